@@ -0,0 +1,31 @@
+#!/bin/bash
+# Pinned vs. unpinned MT workers.
+# Usage: bench/bench_affinity.sh [ROUNDS]
+# Runs ROUNDS execs of three 300-line programs under RR and RR30 MT, once
+# with free-floating workers and once per --cpus layout below.
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ROUNDS=${1:-50}
+build_mysh
+
+for p in 1 2 3; do gen_program "$WORK/p$p" 300 "set v$p x"; done
+for policy in RR RR30; do
+    for i in $(seq 1 "$ROUNDS"); do
+        echo "exec $WORK/p1 $WORK/p2 $WORK/p3 $policy MT"
+    done > "$WORK/batch_$policy"
+    echo "schedstats" >> "$WORK/batch_$policy"
+    echo "quit" >> "$WORK/batch_$policy"
+done
+
+NCPU=$(nproc)
+LAYOUTS="0 0,1 0,$((NCPU / 2))"
+for policy in RR RR30; do
+    echo "== $policy MT, $ROUNDS execs"
+    time_batch "unpinned" "$WORK/batch_$policy"
+    for cpus in $LAYOUTS; do
+        time_batch "--cpus $cpus" "$WORK/batch_$policy" --cpus "$cpus"
+    done
+done
+echo "== placement (last layout)"
+"$MYSH" --cpus "${LAYOUTS##* }" < "$WORK/batch_RR" | grep '^worker'
@@ -0,0 +1,29 @@
+#!/bin/bash
+# Batched MT dispatch: slices/sec for RR (quantum 2) over many short
+# programs, for several --batch sizes.
+# Usage: bench/bench_batch.sh [ROUNDS]
+# Each round queues 31 execs of three 10-line programs (93 processes, 465
+# slices) in the background and waits for them with a final foreground exec.
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ROUNDS=${1:-20}
+build_mysh
+
+for p in 1 2 3; do gen_program "$WORK/p$p" 10 "set v$p x"; done
+PROGS="$WORK/p1 $WORK/p2 $WORK/p3"
+for r in $(seq 1 "$ROUNDS"); do
+    for i in $(seq 1 30); do echo "exec $PROGS RR MT #"; done
+    echo "exec $PROGS RR MT"
+done > "$WORK/batch"
+echo "quit" >> "$WORK/batch"
+SLICES=$((ROUNDS * 31 * 3 * 5))
+
+echo "== RR MT quantum 2, $SLICES slices"
+for b in 1 2 4 8 16; do
+    start=$(date +%s%N)
+    "$MYSH" --batch "$b" < "$WORK/batch" > /dev/null
+    end=$(date +%s%N)
+    awk -v b="$b" -v n="$SLICES" -v ns="$((end - start))" \
+        'BEGIN { printf "--batch %-3d %10.0f slices/s %8.1f ms\n", b, n / (ns / 1e9), ns / 1e6 }'
+done
@@ -0,0 +1,51 @@
+#!/bin/bash
+# Cost of checkpoint snapshots.
+# Usage: bench/bench_checkpoint.sh [SNAPSHOTS] [ROUNDS]
+# First SNAPSHOTS (at most 390) checkpoints taken by a running program
+# while two 300-line programs and 500 variables are queued behind it,
+# against the same run with an echo in place of the checkpoint: the
+# difference is the cost of one snapshot. AGING ends the slice after every
+# instruction, so each checkpoint line writes one. Then ROUNDS execs of three 300-line programs under RR with
+# periodic snapshots (checkpoint ... EVERY N) and without.
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+SNAPSHOTS=${1:-300}
+ROUNDS=${2:-50}
+build_mysh
+
+for i in $(seq 1 500); do echo "set var$i value$i"; done > "$WORK/vars"
+for p in 1 2; do gen_program "$WORK/p$p" 300 "set v$p x"; done
+gen_program "$WORK/ck" "$SNAPSHOTS" "checkpoint $WORK/snap.ckpt"
+gen_program "$WORK/nock" "$SNAPSHOTS" "echo x"
+for prog in ck nock; do
+    { cat "$WORK/vars"; echo "exec $WORK/$prog $WORK/p1 $WORK/p2 AGING"; echo quit; } \
+        > "$WORK/batch_$prog"
+done
+
+echo "== $SNAPSHOTS snapshots of 2 x 300 lines + 500 vars"
+start=$(date +%s%N)
+"$MYSH" < "$WORK/batch_ck" > /dev/null
+mid=$(date +%s%N)
+"$MYSH" < "$WORK/batch_nock" > /dev/null
+end=$(date +%s%N)
+ck=$(( mid - start )); nock=$(( end - mid ))
+printf "%-32s %8.1f ms\n" "with checkpoint" "$(( ck / 1000 ))e-3"
+printf "%-32s %8.1f ms\n" "with echo" "$(( nock / 1000 ))e-3"
+printf "%-32s %8.1f us\n" "per snapshot" "$(( (ck - nock) / SNAPSHOTS / 100 ))e-1"
+printf "%-32s %8d bytes\n" "snapshot size" "$(wc -c < "$WORK/snap.ckpt")"
+
+for p in 1 2 3; do gen_program "$WORK/q$p" 300 "set w$p x"; done
+for every in 0 1000 100; do
+    {
+        [ "$every" -gt 0 ] && echo "checkpoint $WORK/periodic.ckpt EVERY $every"
+        for i in $(seq 1 "$ROUNDS"); do
+            echo "exec $WORK/q1 $WORK/q2 $WORK/q3 RR"
+        done
+        echo quit
+    } > "$WORK/every$every"
+done
+echo "== $ROUNDS execs of 3 x 300 lines, RR"
+time_batch "no checkpoints" "$WORK/every0"
+time_batch "checkpoint EVERY 1000" "$WORK/every1000"
+time_batch "checkpoint EVERY 100" "$WORK/every100"
@@ -0,0 +1,35 @@
+#!/bin/bash
+# Compiled (.mshc) vs text programs: the same execs of P_long-style scripts
+# (straight runs of echo lines), loaded from text and from a compiled
+# image, for short and long scripts.
+# Usage: bench/bench_compile.sh [ROUNDS]
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ROUNDS=${1:-200}
+build_mysh
+
+for lines in 100 330; do
+    for kind in text compiled; do
+        for p in 1 2 3; do
+            gen_program "$WORK/${kind}_${lines}_$p" "$lines" "echo X$p"
+        done
+        for i in $(seq 1 "$ROUNDS"); do
+            echo "exec $WORK/${kind}_${lines}_1 $WORK/${kind}_${lines}_2 $WORK/${kind}_${lines}_3 RR"
+        done > "$WORK/batch_${kind}_$lines"
+    done
+    "$MYSH" --compile "$WORK/compiled_${lines}_1" --compile "$WORK/compiled_${lines}_2" \
+        --compile "$WORK/compiled_${lines}_3" > /dev/null
+done
+
+printf "%-10s %10s %10s\n" "" "text" "image"
+for lines in 100 330; do
+    printf "%-10s %10d %10d\n" "$lines lines" "$(wc -c < "$WORK/text_${lines}_1")" \
+        "$(wc -c < "$WORK/compiled_${lines}_1.mshc")"
+done
+echo "== $ROUNDS execs of 3 programs, RR"
+for lines in 100 330; do
+    for kind in text compiled; do
+        time_batch "$lines lines, $kind" "$WORK/batch_${kind}_$lines"
+    done
+done
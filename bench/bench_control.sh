@@ -0,0 +1,38 @@
+#!/bin/bash
+# repeat loops vs. unrolled scripts.
+# Usage: bench/bench_control.sh [ROUNDS]
+# Both variants execute the same 3 x 300 echo instructions per exec; the
+# looped one stores 3 lines per program instead of 300.
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ROUNDS=${1:-100}
+build_mysh
+
+for p in 1 2 3; do
+    gen_program "$WORK/unrolled$p" 300 "echo X$p"
+    printf 'repeat 300\necho X%s\nend\n' "$p" > "$WORK/looped$p"
+done
+
+for kind in unrolled looped; do
+    for i in $(seq 1 "$ROUNDS"); do
+        echo "exec $WORK/${kind}1 $WORK/${kind}2 $WORK/${kind}3 RR"
+    done > "$WORK/batch_$kind"
+done
+
+printf "%-10s %12s %12s\n" "" "code lines" "script bytes"
+for kind in unrolled looped; do
+    printf "%-10s %12d %12d\n" "$kind" \
+        "$(cat "$WORK/${kind}"[123] | wc -l)" "$(cat "$WORK/${kind}"[123] | wc -c)"
+done
+echo "== $ROUNDS execs, RR"
+for kind in unrolled looped; do
+    time_batch "$kind" "$WORK/batch_$kind"
+    echo "  peak RSS $(peak_rss_kb "$WORK/batch_$kind") KiB"
+done
+
+# A loop can run far more instructions than MEM_SIZE lines could ever hold.
+printf 'repeat 100000\nset v x\nend\n' > "$WORK/big"
+echo "exec $WORK/big RR" > "$WORK/batch_big"
+time_batch "looped, 100000 instructions" "$WORK/batch_big"
+echo "  peak RSS $(peak_rss_kb "$WORK/batch_big") KiB"
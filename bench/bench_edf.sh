@@ -0,0 +1,30 @@
+#!/bin/bash
+# EDF dispatch cost.
+# Usage: bench/bench_edf.sh [ROUNDS]
+# First the ready queue alone (bench/rqbench.c): ns per EDF dispatch at
+# 3 to 30000 queued programs, against a sorted list. Then ROUNDS execs of
+# three 300-line programs under EDF and under AGING, the other policy
+# that dispatches every instruction.
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ROUNDS=${1:-100}
+make -s rqbench
+build_mysh
+
+echo "== ready queue, ns per dispatch"
+./rqbench
+
+for p in 1 2 3; do gen_program "$WORK/p$p" 300 "set v$p x"; done
+for i in $(seq 1 "$ROUNDS"); do
+    echo "exec $WORK/p1 $WORK/p2 $WORK/p3 EDF DEADLINE 900 600 300"
+done > "$WORK/edf"
+for i in $(seq 1 "$ROUNDS"); do
+    echo "exec $WORK/p1 $WORK/p2 $WORK/p3 AGING"
+done > "$WORK/aging"
+echo "edfstats" >> "$WORK/edf"
+echo "quit" | tee -a "$WORK/edf" >> "$WORK/aging"
+echo "== $ROUNDS execs of 3 x 300 lines"
+time_batch "EDF" "$WORK/edf"
+time_batch "AGING" "$WORK/aging"
+"$MYSH" < "$WORK/edf" | grep '^EDF'
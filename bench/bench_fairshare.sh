@@ -0,0 +1,68 @@
+#!/bin/bash
+# Weighted fair sharing between exec batches.
+# Usage: bench/bench_fairshare.sh [ROUNDS]
+# Share: a background batch A overlaps a batch B of three programs, both
+# RR MT, every program a loop of echos. Prints A's share of the lines run
+# while both batches had programs left, for five runs ('-': A was done
+# before B started).
+#   A = one program, equal weights: fair is 0.50 (0.25 if every program
+#       got an equal share, as without batches)
+#   A = three programs, WEIGHT W: fair is W / (W + 1)
+# Overhead: ROUNDS rounds of four overlapping background execs.
+# Set BASE to a mysh built from an older commit to compare against it
+# (equal weights only, older builds do not take WEIGHT).
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ROUNDS=${1:-50}
+LOOPS=20000
+build_mysh
+
+for p in 1 2 3; do
+    printf 'repeat %s\necho A\nend\n' "$LOOPS" > "$WORK/a$p"
+    printf 'repeat %s\necho B\nend\n' "$LOOPS" > "$WORK/b$p"
+done
+
+# share BIN "A PROGRAMS" [WEIGHT_A]: A's share in each of five runs
+share() {
+    local bin=$1 progs=$2 weight=${3:+WEIGHT $3}
+    for run in 1 2 3 4 5; do
+        printf "exec %s RR MT %s #\nexec %s RR MT\nquit\n" \
+            "$progs" "$weight" "$WORK/b1 $WORK/b2 $WORK/b3" | "$bin" | awk '
+            $1 == "A" || $1 == "B" { l[n++] = $1 }
+            END {
+                fb = -1
+                for (i = 0; i < n; i++) {
+                    if (l[i] == "B" && fb < 0) fb = i
+                    if (l[i] == "A") la = i; else lb = i
+                }
+                last = la < lb ? la : lb
+                for (i = fb; i <= last; i++) if (l[i] == "A") a++; else b++
+                if (fb < 0 || a + b == 0) printf " -"
+                else printf " %.2f", a / (a + b)
+            }'
+    done
+    echo
+}
+
+echo "== share, A one program vs B three (fair 0.50)"
+printf "%-10s " "$(basename "$MYSH")"; share "$MYSH" "$WORK/a1"
+if [ -n "$BASE" ]; then
+    printf "%-10s " "base"; share "$BASE" "$WORK/a1"
+fi
+echo "== share, A three programs WEIGHT W vs B three (fair W/(W+1))"
+for w in 1 3 9; do
+    printf "%-10s " "WEIGHT $w"; share "$MYSH" "$WORK/a1 $WORK/a2 $WORK/a3" "$w"
+done
+
+for p in 1 2 3 4; do gen_program "$WORK/o$p" 200 "set v$p x"; done
+for i in $(seq 1 "$ROUNDS"); do
+    for p in 1 2 3; do echo "exec $WORK/o$p RR MT #"; done
+    echo "exec $WORK/o4 RR MT"
+done > "$WORK/batch"
+echo "quit" >> "$WORK/batch"
+echo "== overhead, $ROUNDS rounds of 4 overlapping execs"
+time_batch "$(basename "$MYSH")" "$WORK/batch"
+if [ -n "$BASE" ]; then
+    MYSH=$BASE time_batch "base" "$WORK/batch"
+fi
@@ -0,0 +1,46 @@
+#!/bin/bash
+# Idle MT workers: spin-then-park against parking at once.
+# Usage: bench/bench_idle.sh [ROUNDS]
+# ROUNDS execs of three 300-line programs under RR (quantum 2) MT, with
+# the default spin (none on a single CPU), --spin 0 and --spin 4096.
+# Prints wall time, slices/sec, the context switches of the whole run and
+# the worker counters from schedstats.
+# Set BASE to a mysh built from an older commit to compare against it.
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ROUNDS=${1:-100}
+build_mysh
+
+for p in 1 2 3; do gen_program "$WORK/p$p" 300 "set v$p x"; done
+for i in $(seq 1 "$ROUNDS"); do
+    echo "exec $WORK/p1 $WORK/p2 $WORK/p3 RR MT"
+done > "$WORK/batch"
+echo "schedstats" >> "$WORK/batch"
+echo "quit" >> "$WORK/batch"
+
+# run LABEL BIN [MYSH ARGS...]
+run() {
+    local label=$1 bin=$2
+    shift 2
+    local start end ms slices
+    start=$(date +%s%N)
+    slices=$("$bin" "$@" < "$WORK/batch" | awk '
+        /^worker/ { for (i = 1; i < NF; i++) if ($i == "slices") s += $(i + 1) }
+        END { print s + 0 }')
+    end=$(date +%s%N)
+    ms=$(( (end - start) / 1000000 ))
+    [ "$ms" -gt 0 ] || ms=1
+    printf "%-14s %6d ms %9d slices/s  csw vol/invol %s\n" "$label" "$ms" \
+        "$(( slices * 1000 / ms ))" "$(MYSH=$bin ctx_switches "$WORK/batch" "$@" | tr ' ' /)"
+}
+
+echo "== $ROUNDS RR MT execs of 3 x 300 lines, $(nproc) CPU(s)"
+run "default" "$MYSH"
+run "--spin 0" "$MYSH" --spin 0
+run "--spin 4096" "$MYSH" --spin 4096
+if [ -n "$BASE" ]; then
+    run "base" "$BASE"
+fi
+echo "== counters (default)"
+"$MYSH" < "$WORK/batch" | grep -E '^(worker|wakeups)'
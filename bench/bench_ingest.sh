@@ -0,0 +1,22 @@
+#!/bin/bash
+# Batch-input ingest rate on a large piped batch file.
+# Usage: bench/bench_ingest.sh [MEGABYTES]
+# Feeds MEGABYTES of short set commands, then of blank lines (pure
+# line-splitting cost) through a pipe, as `cat file | mysh` would.
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+MB=${1:-256}
+build_mysh
+
+yes "set x abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklm" \
+    | head -c "${MB}M" > "$WORK/commands"
+yes "" | head -c "${MB}M" > "$WORK/blank"
+
+for kind in commands blank; do
+    start=$(date +%s%N)
+    cat "$WORK/$kind" | "$MYSH" > /dev/null
+    end=$(date +%s%N)
+    awk -v k="$kind" -v mb="$MB" -v ns="$((end - start))" \
+        'BEGIN { printf "%-9s %6d MB %9.1f ms %8.1f MB/s\n", k, mb, ns / 1e6, mb / (ns / 1e9) }'
+done
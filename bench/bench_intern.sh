@@ -0,0 +1,49 @@
+#!/bin/bash
+# String interning: variable stores and lookups with many repeated names,
+# and memory for scripts made of the same few lines.
+# The interner's own counters (stats) give the memory saved; peak RSS is
+# too coarse to show it at these sizes.
+# Set BASE to a mysh built from an older commit to compare against it.
+# Usage: bench/bench_intern.sh [VARS] [ROUNDS]
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+VARS=${1:-500}
+ROUNDS=${2:-20}
+build_mysh
+
+# VARS variables, then ROUNDS passes that overwrite and print each of them
+# with one of a handful of values.
+{
+    for i in $(seq 1 "$VARS"); do echo "set variable_$i shell"; done
+    for r in $(seq 1 "$ROUNDS"); do
+        for i in $(seq 1 "$VARS"); do
+            echo "set variable_$i value_$((i % 4))"
+            echo "print variable_$i"
+        done
+    done
+    echo stats
+    echo quit
+} > "$WORK/vars"
+
+# Three 330-line scripts of the same line, run RR; the first one ends with
+# stats, when nearly all lines of all three have been loaded.
+for p in 1 2 3; do
+    gen_program "$WORK/same$p" 330 "echo X"
+done
+sed -i '$s/.*/stats/' "$WORK/same1"
+printf 'exec %s %s %s RR\nquit\n' "$WORK/same1" "$WORK/same2" "$WORK/same3" > "$WORK/lines"
+
+echo "== $VARS variables, $ROUNDS x (set + print) each"
+for bin in "$MYSH" ${BASE:+"$BASE"}; do
+    label=new; [ "$bin" = "$MYSH" ] || label=base
+    MYSH=$bin time_batch "$label" "$WORK/vars"
+    printf "%-32s %8d KiB\n" "$label peak RSS" "$(MYSH=$bin peak_rss_kb "$WORK/vars")"
+done
+"$MYSH" < "$WORK/vars" | grep '^interned'
+echo "== 3 x 330 identical lines loaded"
+for bin in "$MYSH" ${BASE:+"$BASE"}; do
+    label=new; [ "$bin" = "$MYSH" ] || label=base
+    printf "%-32s %8d KiB\n" "$label peak RSS" "$(MYSH=$bin peak_rss_kb "$WORK/lines")"
+done
+"$MYSH" < "$WORK/lines" | grep '^interned'
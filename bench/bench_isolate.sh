@@ -0,0 +1,30 @@
+#!/bin/bash
+# Variable-heavy MT jobs: shared shellmemory vs. exec ... ISOLATE.
+# Usage: bench/bench_isolate.sh [ITERATIONS]
+# Three programs each loop ITERATIONS times over set + echo of their own
+# variables. Shared jobs serialize on the shellmemory lock and scan the
+# 1000-slot array; isolated jobs hit their private overlay.
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ITER=${1:-20000}
+build_mysh
+
+for p in 1 2 3; do
+    printf 'repeat %d\nset a%s x\nset b%s y\necho $a%s\necho $b%s\nend\n' \
+        "$ITER" "$p" "$p" "$p" "$p" > "$WORK/p$p"
+done
+# Some unrelated shell variables, so the shared scan has work to do.
+for i in $(seq 1 200); do echo "set pad$i v"; done > "$WORK/setup"
+
+INSTR=$((ITER * 4 * 3))
+for mode in "" ISOLATE; do
+    for policy in "RR" "RR MT" "RR30 MT"; do
+        { cat "$WORK/setup"; echo "exec $WORK/p1 $WORK/p2 $WORK/p3 $policy $mode"; echo quit; } > "$WORK/batch"
+        start=$(date +%s%N)
+        "$MYSH" < "$WORK/batch" > /dev/null
+        end=$(date +%s%N)
+        awk -v l="$policy ${mode:-shared}" -v n="$INSTR" -v ns="$((end - start))" \
+            'BEGIN { printf "%-22s %9.1f ms %8.1f ns/instr\n", l, ns / 1e6, ns / n }'
+    done
+done
@@ -0,0 +1,36 @@
+#!/bin/bash
+# Demand-paged script loading: wall time and peak RSS for an exec of the
+# largest script code memory holds (1000 lines of ~990 bytes), when the
+# program quits after two lines and when it runs to the end.
+# Set BASE to a mysh built from an older commit to compare against it.
+# Usage: bench/bench_lazyload.sh [ROUNDS]
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ROUNDS=${1:-50}
+build_mysh
+
+pad=$(printf '%0980d' 0)
+{ echo "echo start"; echo quit; for i in $(seq 3 1000); do echo "set v $pad"; done; } > "$WORK/early"
+{ echo "echo start"; for i in $(seq 2 1000); do echo "set v $pad"; done; } > "$WORK/full"
+for kind in early full; do
+    for i in $(seq 1 "$ROUNDS"); do echo "exec $WORK/$kind FCFS"; done > "$WORK/batch_$kind"
+    echo "exec $WORK/$kind FCFS" > "$WORK/once_$kind"
+done
+
+for kind in early full; do
+    echo "== $kind: $ROUNDS execs / peak RSS of one"
+    for bin in "$MYSH" ${BASE:+"$BASE"}; do
+        label=new; [ "$bin" = "$MYSH" ] || label=base
+        # an early quit ends the shell, so time one exec per process
+        if [ $kind = early ]; then
+            start=$(date +%s%N)
+            for i in $(seq 1 "$ROUNDS"); do "$bin" < "$WORK/once_$kind" > /dev/null; done
+            end=$(date +%s%N)
+            printf "%-32s %8.1f ms\n" "$label" "$(( (end - start) / 1000 ))e-3"
+        else
+            MYSH=$bin time_batch "$label" "$WORK/batch_$kind"
+        fi
+        printf "%-32s %8d KiB\n" "$label peak RSS" "$(MYSH=$bin peak_rss_kb "$WORK/once_$kind")"
+    done
+done
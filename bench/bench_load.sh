@@ -0,0 +1,64 @@
+#!/bin/bash
+# Script loading for multi-program execs: time from the exec command to
+# its first instruction, and to the end of the exec, for execs of three
+# large scripts. Each script is read on its own thread; with MT, the first
+# program runs as soon as its script is in.
+# Set BASE to a mysh built from an older commit to compare against it.
+# Usage: bench/bench_load.sh [ROUNDS]
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ROUNDS=${1:-50}
+build_mysh
+
+# 3 x 330 lines of ~900 bytes: as much as code memory holds.
+pad=$(printf '%0880d' 0)
+for p in 1 2 3; do
+    { echo "echo FIRST"; for i in $(seq 2 330); do echo "set v$p $pad"; done; } > "$WORK/s$p"
+done
+
+# ttfi MYSH POLICY: median ms from writing the exec line to the first
+# FIRST, and to the echo after the exec, over ROUNDS runs. stdout is a pty
+# so every echo reaches us as soon as it runs.
+ttfi() {
+    python3 - "$1" "$2" "$ROUNDS" "$WORK" <<'PY'
+import os, pty, subprocess, sys, time
+mysh, policy, rounds, work = sys.argv[1], sys.argv[2], int(sys.argv[3]), sys.argv[4]
+first, total = [], []
+for _ in range(rounds):
+    master, slave = pty.openpty()
+    p = subprocess.Popen([mysh], stdin=subprocess.PIPE, stdout=slave, stderr=subprocess.DEVNULL)
+    os.close(slave)
+    t0 = time.perf_counter()
+    p.stdin.write(f"exec {work}/s1 {work}/s2 {work}/s3 {policy}\necho DONE\nquit\n".encode())
+    p.stdin.flush()
+    buf, t_first, t_done = b"", None, None
+    while t_done is None:
+        try:
+            chunk = os.read(master, 65536)
+        except OSError:
+            break
+        if not chunk:
+            break
+        buf += chunk
+        now = time.perf_counter()
+        if t_first is None and b"FIRST" in buf:
+            t_first = now
+        if b"DONE" in buf:
+            t_done = now
+    p.wait()
+    os.close(master)
+    first.append((t_first - t0) * 1e3)
+    total.append((t_done - t0) * 1e3)
+first.sort(); total.sort()
+print(f"first instruction {first[len(first)//2]:7.2f} ms   exec done {total[len(total)//2]:7.2f} ms")
+PY
+}
+
+echo "== exec of 3 x 330 lines x 900 bytes, median of $ROUNDS"
+for policy in RR "RR MT"; do
+    printf "%-10s %-6s " "${policy}" "new"; ttfi "$MYSH" "$policy"
+    if [ -n "$BASE" ]; then
+        printf "%-10s %-6s " "${policy}" "base"; ttfi "$BASE" "$policy"
+    fi
+done
@@ -0,0 +1,39 @@
+#!/bin/bash
+# my_ls on a large directory.
+# Usage: bench/bench_ls.sh [ENTRIES] [LISTINGS]
+# LISTINGS my_ls of one directory of ENTRIES files, first unchanged between
+# listings (served from the cache after the first), then with a file
+# created before each listing (every one sorted afresh).
+# Set BASE to a mysh built from an older commit to compare against it.
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ENTRIES=${1:-100000}
+LISTINGS=${2:-20}
+build_mysh
+# The batches run in $WORK, where my_cd can reach the directory.
+MYSH=$(realpath "$MYSH")
+[ -n "$BASE" ] && BASE=$(realpath "$BASE")
+
+mkdir "$WORK/big"
+seq -f "f%.0f" 1 "$ENTRIES" | (cd "$WORK/big" && xargs touch)
+{
+    echo "my_cd big"
+    for i in $(seq 1 "$LISTINGS"); do echo "my_ls"; done
+    echo "quit"
+} > "$WORK/same"
+{
+    echo "my_cd big"
+    for i in $(seq 1 "$LISTINGS"); do echo "my_touch new$i"; echo "my_ls"; done
+    echo "quit"
+} > "$WORK/changed"
+
+cd "$WORK"
+for bin in "$MYSH" ${BASE:+"$BASE"}; do
+    label=$([ "$bin" = "$MYSH" ] && echo mysh || echo base)
+    echo "== $label: $LISTINGS listings of $ENTRIES entries"
+    MYSH=$bin time_batch "unchanged" same
+    rm -f big/new*
+    MYSH=$bin time_batch "changed before each" changed
+    rm -f big/new*
+done
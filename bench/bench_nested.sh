@@ -0,0 +1,40 @@
+#!/bin/bash
+# Nested source: a deep chain of scripts and a binary tree of them.
+# Usage: bench/bench_nested.sh [ROUNDS] [DEPTH]
+# Each chain level echoes, sources the next level and echoes again; each
+# tree level sources the level below twice, so a depth-D tree runs
+# 2^D - 1 nested sources per round.
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ROUNDS=${1:-50}
+DEPTH=${2:-10}
+build_mysh
+
+for i in $(seq 1 "$DEPTH"); do
+    next=$((i + 1))
+    if [ "$i" -lt "$DEPTH" ]; then
+        printf 'echo C%s\nsource %s/chain%s\necho C%s\n' "$i" "$WORK" "$next" "$i" > "$WORK/chain$i"
+        printf 'source %s/tree%s\nsource %s/tree%s\n' "$WORK" "$next" "$WORK" "$next" > "$WORK/tree$i"
+    else
+        printf 'echo C%s\n' "$i" > "$WORK/chain$i"
+        printf 'echo T%s\n' "$i" > "$WORK/tree$i"
+    fi
+done
+
+for kind in chain tree; do
+    for r in $(seq 1 "$ROUNDS"); do
+        echo "source $WORK/${kind}1"
+    done > "$WORK/batch_$kind"
+    # The same nesting under a running RR exec alongside another program.
+    gen_program "$WORK/other" 20
+    for r in $(seq 1 "$ROUNDS"); do
+        echo "exec $WORK/${kind}1 $WORK/other RR"
+    done > "$WORK/batch_${kind}_rr"
+done
+
+echo "== $ROUNDS rounds, depth $DEPTH"
+for kind in chain tree; do
+    time_batch "$kind, source" "$WORK/batch_$kind"
+    time_batch "$kind, exec RR" "$WORK/batch_${kind}_rr"
+done
@@ -0,0 +1,26 @@
+#!/bin/bash
+# Per-instruction cost of each scheduling policy.
+# Usage: bench/bench_policy.sh [ROUNDS]
+# Every policy runs the same ROUNDS execs of three 300-line programs of
+# cheap "set" instructions; the ns/instruction difference between policies
+# is scheduler overhead (queue operations, requeue, aging).
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ROUNDS=${1:-100}
+build_mysh
+
+for p in 1 2 3; do gen_program "$WORK/p$p" 300 "set v$p x"; done
+INSTR=$((ROUNDS * 900))
+
+printf "%-8s %10s %12s\n" policy ms ns/instr
+for policy in FCFS SJF RR RR30 AGING; do
+    for i in $(seq 1 "$ROUNDS"); do
+        echo "exec $WORK/p1 $WORK/p2 $WORK/p3 $policy"
+    done > "$WORK/batch"
+    start=$(date +%s%N)
+    "$MYSH" < "$WORK/batch" > /dev/null
+    end=$(date +%s%N)
+    awk -v p="$policy" -v n="$INSTR" -v ns="$((end - start))" \
+        'BEGIN { printf "%-8s %10.1f %12.1f\n", p, ns / 1e6, ns / n }'
+done
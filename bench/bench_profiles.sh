@@ -0,0 +1,40 @@
+#!/bin/bash
+# Build profiles side by side: debug (-O0), release (-O2 + LTO) and profile
+# (release + PGO trained by bench/pgo_train.sh) on the same workloads.
+# Usage: bench/bench_profiles.sh [ROUNDS]
+# Builds into src/build/ and leaves src/mysh as the release binary.
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ROUNDS=${1:-100}
+
+make -s -C ../src PROFILE=debug build/debug/mysh > /dev/null
+make -s -C ../src pgo > /dev/null
+make -s -C ../src release > /dev/null
+
+for p in 1 2 3; do
+    gen_program "$WORK/set$p" 300 "set v$p x"
+    gen_program "$WORK/echo$p" 300
+done
+for i in $(seq 1 "$ROUNDS"); do
+    echo "exec $WORK/set1 $WORK/set2 $WORK/set3 RR"
+done > "$WORK/batch_rr"
+for i in $(seq 1 "$ROUNDS"); do
+    echo "exec $WORK/set1 $WORK/set2 $WORK/set3 AGING"
+done > "$WORK/batch_aging"
+for i in $(seq 1 "$ROUNDS"); do
+    echo "exec $WORK/echo1 $WORK/echo2 $WORK/echo3 RR MT"
+done > "$WORK/batch_mt"
+echo quit >> "$WORK/batch_mt"
+for i in $(seq 1 $((ROUNDS * 300))); do
+    echo "set a$((i % 50)) b; echo \$a$((i % 50))"
+done > "$WORK/batch_prompt"
+
+for build in debug release profile; do
+    MYSH=../src/build/$build/mysh
+    echo "== $build ($(stat -c %s "$MYSH") bytes)"
+    time_batch "RR, set" "$WORK/batch_rr"
+    time_batch "AGING, set" "$WORK/batch_aging"
+    time_batch "MT RR, echo" "$WORK/batch_mt"
+    time_batch "prompt, set+echo" "$WORK/batch_prompt"
+done
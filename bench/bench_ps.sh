@@ -0,0 +1,25 @@
+#!/bin/bash
+# Cost of ps snapshots to a running MT exec: a background RR MT run with
+# the shell idle, then with the shell taking PS snapshots as fast as it can
+# while the workers dispatch. ps never takes the scheduler lock, so the two
+# should differ only by the shell thread's own CPU time.
+# Usage: bench/bench_ps.sh [PS] [ITERATIONS]
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+PS=${1:-2000}
+ITERATIONS=${2:-200000}
+build_mysh
+
+for p in 1 2 3; do
+    printf 'repeat %s\nset v%s x\nend\n' "$ITERATIONS" "$p" > "$WORK/p$p"
+done
+exec_line="exec $WORK/p1 $WORK/p2 $WORK/p3 RR MT #"
+{ echo "$exec_line"; echo quit; } > "$WORK/idle"
+{ echo "$exec_line"; for i in $(seq 1 "$PS"); do echo ps; done; echo quit; } > "$WORK/ps"
+
+echo "== RR MT, 3 x $ITERATIONS set commands"
+time_batch "shell idle" "$WORK/idle"
+time_batch "shell running $PS x ps" "$WORK/ps"
+"$MYSH" < "$WORK/ps" | awk '$3 == "RUNNING" { r++ } $3 == "READY" { q++ }
+    END { printf "snapshots saw %d running and %d queued rows\n", r, q }'
@@ -0,0 +1,32 @@
+#!/bin/bash
+# Cost of quota accounting: the same workload with no quotas, with an
+# instruction/variable quota that is never reached, and with a time quota
+# (the only one that reads the clock).
+# Usage: bench/bench_quota.sh [ROUNDS] [LINES]
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ROUNDS=${1:-100}
+LINES=${2:-300}
+build_mysh
+
+for p in 1 2 3; do
+    gen_program "$WORK/p$p" "$LINES" "set v$p x"
+done
+for policy in FCFS RR AGING; do
+    for i in $(seq 1 "$ROUNDS"); do
+        echo "exec $WORK/p1 $WORK/p2 $WORK/p3 $policy"
+    done > "$WORK/run_$policy"
+    cp "$WORK/run_$policy" "$WORK/none_$policy"
+    { printf 'quota instructions 1000000000\nquota vars 1000\nquota action kill\n'
+      cat "$WORK/run_$policy"; } > "$WORK/count_$policy"
+    { printf 'quota time 1000000\nquota action kill\n'
+      cat "$WORK/run_$policy"; } > "$WORK/time_$policy"
+done
+
+echo "== $ROUNDS execs of 3 x $LINES set commands"
+for policy in FCFS RR AGING; do
+    time_batch "$policy, no quota" "$WORK/none_$policy"
+    time_batch "$policy, instructions+vars" "$WORK/count_$policy"
+    time_batch "$policy, time" "$WORK/time_$policy"
+done
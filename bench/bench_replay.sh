@@ -0,0 +1,32 @@
+#!/bin/bash
+# MT record/replay: cost of --record against a plain MT run, replay speed,
+# and whether two replays of one log print the same output.
+# Usage: bench/bench_replay.sh [ROUNDS] [LINES]
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ROUNDS=${1:-200}
+LINES=${2:-60}
+build_mysh
+
+for p in 1 2 3; do
+    gen_program "$WORK/p$p" "$LINES" "echo P$p"
+done
+for i in $(seq 1 "$ROUNDS"); do
+    echo "exec $WORK/p1 $WORK/p2 $WORK/p3 RR MT"
+done > "$WORK/batch"
+echo quit >> "$WORK/batch"
+
+echo "== $ROUNDS MT RR execs of 3 x $LINES lines"
+time_batch "MT, no log" "$WORK/batch"
+time_batch "MT, --record" "$WORK/batch" --record "$WORK/log"
+echo "  log: $(wc -c < "$WORK/log") bytes"
+time_batch "MT, --replay" "$WORK/batch" --replay "$WORK/log"
+
+"$MYSH" --replay "$WORK/log" < "$WORK/batch" > "$WORK/out1"
+"$MYSH" --replay "$WORK/log" < "$WORK/batch" > "$WORK/out2"
+if cmp -s "$WORK/out1" "$WORK/out2"; then
+    echo "replays identical: yes"
+else
+    echo "replays identical: NO"
+fi
@@ -0,0 +1,39 @@
+#!/bin/bash
+# Per-worker run queues vs. the one global ready queue.
+# Usage: bench/bench_runqueue.sh [ROUNDS]
+# Runs ROUNDS execs of three 600-line programs under RR and RR30 MT, with
+# the default per-worker queues and with --global-queue, and reports wall
+# time plus how many slices ran on a different worker than the one before.
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ROUNDS=${1:-50}
+build_mysh
+
+for p in 1 2 3; do gen_program "$WORK/p$p" 600 "set v$p x"; done
+for policy in RR RR30; do
+    for i in $(seq 1 "$ROUNDS"); do
+        echo "exec $WORK/p1 $WORK/p2 $WORK/p3 $policy MT"
+    done > "$WORK/batch_$policy"
+    echo "schedstats" >> "$WORK/batch_$policy"
+    echo "quit" >> "$WORK/batch_$policy"
+done
+
+# migrations LABEL BATCH [MYSH ARGS...]: total migrations and slices
+migrations() {
+    local label=$1 batch=$2
+    shift 2
+    "$MYSH" "$@" < "$batch" | awk -v label="$label" '
+        /^worker/ { for (i = 1; i < NF; i++) {
+                        if ($i == "slices") s += $(i + 1)
+                        if ($i == "migrations") m += $(i + 1) } }
+        END { printf "%-32s %8d of %d slices migrated\n", label, m, s }'
+}
+
+for policy in RR RR30; do
+    echo "== $policy MT, $ROUNDS execs"
+    time_batch "local queues" "$WORK/batch_$policy"
+    time_batch "--global-queue" "$WORK/batch_$policy" --global-queue
+    migrations "local queues" "$WORK/batch_$policy"
+    migrations "--global-queue" "$WORK/batch_$policy" --global-queue
+done
@@ -0,0 +1,30 @@
+#!/bin/bash
+# Service mode vs. one mysh process per batch.
+# Usage: bench/bench_serve.sh [REQUESTS_PER_CLIENT]
+set -e
+cd "$(dirname "$0")"
+REQUESTS=${1:-200}
+WORK=$(mktemp -d)
+trap 'kill $SERVER 2>/dev/null; rm -rf "$WORK"' EXIT
+
+make -s -C ../src mysh
+make -s loadtest
+
+for i in $(seq 1 20); do echo "echo line$i"; done > "$WORK/prog"
+SOCK="$WORK/mysh.sock"
+
+echo "== one process per request (pipe into mysh)"
+start=$(date +%s.%N)
+for i in $(seq 1 "$REQUESTS"); do
+    echo "exec $WORK/prog RR" | ../src/mysh > /dev/null
+done
+end=$(date +%s.%N)
+awk -v n="$REQUESTS" -v s="$start" -v e="$end" 'BEGIN { printf "%d requests: %.0f req/s\n", n, n / (e - s) }'
+
+echo "== mysh --serve"
+../src/mysh --serve "$SOCK" > /dev/null &
+SERVER=$!
+while [ ! -S "$SOCK" ]; do sleep 0.05; done
+./loadtest "$SOCK" "$REQUESTS" 1,2,4,8,16 "exec $WORK/prog RR"
+echo "-- MT workers"
+./loadtest "$SOCK" "$REQUESTS" 1,4,16 "exec $WORK/prog RR MT"
@@ -0,0 +1,29 @@
+#!/bin/bash
+# Tail latency of short jobs queued behind a long one: instruction quanta
+# vs. TIMESLICE wall-clock quanta.
+# Usage: bench/bench_timeslice.sh [ROUNDS]
+# The long job's commands each take ~10 ms (run sleep), so an RR30 slice
+# holds the CPU for ~200 ms; a 5 ms TIMESLICE lets it run one command at a
+# time. Each short job stamps its completion with `run date`.
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+ROUNDS=${1:-10}
+build_mysh
+
+printf 'repeat 20\nrun sleep 0.01\nend\n' > "$WORK/long"
+for s in 1 2; do printf 'echo short%s\nrun date +%%s%%N\n' "$s" > "$WORK/short$s"; done
+
+for mode in "RR30" "RR30 TIMESLICE 5" "RR30 MT" "RR30 MT TIMESLICE 5"; do
+    for i in $(seq 1 "$ROUNDS"); do
+        echo "run date +%s%N"
+        echo "exec $WORK/long $WORK/short1 $WORK/short2 $mode"
+    done > "$WORK/batch"
+    # Latency of a short job = its stamp minus the stamp before its exec.
+    "$MYSH" < "$WORK/batch" \
+        | awk '/^[0-9]+$/ { if (k++ % 3 == 0) t0 = $1; else print ($1 - t0) / 1e6 }' \
+        | sort -n \
+        | awk -v m="$mode" '{ lat[n++] = $1 }
+            END { printf "%-22s p50 %7.1f ms  p90 %7.1f ms  max %7.1f ms\n", m,
+                  lat[int(n * 0.5)], lat[int(n * 0.9)], lat[n - 1] }'
+done
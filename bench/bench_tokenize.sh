@@ -0,0 +1,19 @@
+#!/bin/bash
+# SIMD tokenizer: checks it against the scalar one (test-cases and fuzzed
+# commands), then times both on short script lines and on long commands.
+# Usage: bench/bench_tokenize.sh [FUZZ_CASES]
+set -e
+cd "$(dirname "$0")"
+. ./common.sh
+FUZZ=${1:-100000}
+make -s tokcheck
+
+echo "== test-cases"
+./tokcheck -f "$FUZZ" ../test-cases/T_* ../test-cases/P_*
+
+for i in $(seq 1 200); do
+    echo "set var$i some_value_$i; echo \$var$i; print var$i"
+    printf 'echo'; for w in $(seq 1 40); do printf ' word%s' "$w"; done; echo
+done > "$WORK/long"
+echo "== long commands"
+./tokcheck -f 0 "$WORK/long"
@@ -0,0 +1,49 @@
+# Shared helpers for the bench_*.sh scripts. Source it after cd'ing into
+# bench/.
+
+# Set MYSH to benchmark another binary (e.g. a build of an older commit).
+MYSH=${MYSH:-../src/mysh}
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+
+build_mysh() {
+    if [ "$MYSH" = ../src/mysh ]; then
+        make -s -C ../src mysh
+    fi
+}
+
+# gen_program FILE LINES [COMMAND]: a straight-line program of LINES
+# commands (default: echo of the line number).
+gen_program() {
+    local file=$1 lines=$2 cmd=${3:-}
+    for i in $(seq 1 "$lines"); do
+        if [ -n "$cmd" ]; then echo "$cmd"; else echo "echo L$i"; fi
+    done > "$file"
+}
+
+# time_batch LABEL BATCH_FILE [MYSH ARGS...]: wall time of one mysh run.
+time_batch() {
+    local label=$1 batch=$2
+    shift 2
+    local start end
+    start=$(date +%s%N)
+    "$MYSH" "$@" < "$batch" > /dev/null
+    end=$(date +%s%N)
+    printf "%-32s %8.1f ms\n" "$label" "$(( (end - start) / 1000 ))e-3"
+}
+
+# peak_rss_kb BATCH_FILE [MYSH ARGS...]: peak RSS of one mysh run, in KiB.
+peak_rss_kb() {
+    local batch=$1
+    shift
+    make -s peakrss
+    ./peakrss "$MYSH" "$@" < "$batch"
+}
+# ctx_switches BATCH_FILE [MYSH ARGS...]: voluntary and involuntary context
+# switches of one mysh run.
+ctx_switches() {
+    local batch=$1
+    shift
+    make -s peakrss
+    ./peakrss -c "$MYSH" "$@" < "$batch"
+}
@@ -0,0 +1,138 @@
+// Load-test client for mysh --serve.
+// Usage: loadtest SOCKET REQUESTS CONCURRENCY[,CONCURRENCY...] COMMAND
+// Each of CONCURRENCY client threads opens its own connection and sends
+// REQUESTS copies of COMMAND back to back, timing each round trip (until
+// the '\0' end-of-response marker).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+typedef struct {
+    const char *socket_path;
+    const char *command;
+    int requests;
+    double *latencies_us;
+    int failed;
+} ClientArgs;
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int connect_to(const char *path) {
+    struct sockaddr_un addr;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Read until the end-of-response marker. Returns 0 on success.
+static int read_response(int fd) {
+    char buf[4096];
+    while (1) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) return -1;
+        if (memchr(buf, '\0', n) != NULL) return 0;
+    }
+}
+
+static void *client_thread(void *arg) {
+    ClientArgs *a = arg;
+    size_t cmd_len = strlen(a->command);
+    int fd = connect_to(a->socket_path);
+
+    if (fd < 0) {
+        a->failed = a->requests;
+        return NULL;
+    }
+    for (int i = 0; i < a->requests; i++) {
+        double start = now_us();
+        if (write(fd, a->command, cmd_len) != (ssize_t) cmd_len
+            || read_response(fd) != 0) {
+            a->failed = a->requests - i;
+            break;
+        }
+        a->latencies_us[i] = now_us() - start;
+    }
+    close(fd);
+    return NULL;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static void run_level(const char *path, const char *command, int requests,
+                      int concurrency) {
+    pthread_t threads[concurrency];
+    ClientArgs args[concurrency];
+    double *all = malloc(sizeof(double) * requests * concurrency);
+    int done = 0, failed = 0;
+
+    double start = now_us();
+    for (int i = 0; i < concurrency; i++) {
+        args[i].socket_path = path;
+        args[i].command = command;
+        args[i].requests = requests;
+        args[i].latencies_us = all + (size_t) i * requests;
+        args[i].failed = 0;
+        pthread_create(&threads[i], NULL, client_thread, &args[i]);
+    }
+    for (int i = 0; i < concurrency; i++) {
+        pthread_join(threads[i], NULL);
+        failed += args[i].failed;
+    }
+    double elapsed_s = (now_us() - start) / 1e6;
+
+    // Compact the successful samples so the percentiles only see real ones.
+    for (int i = 0; i < concurrency; i++) {
+        int ok = requests - args[i].failed;
+        memmove(all + done, args[i].latencies_us, sizeof(double) * ok);
+        done += ok;
+    }
+    qsort(all, done, sizeof(double), compare_double);
+
+    if (done == 0) {
+        printf("%11d  all %d requests failed\n", concurrency, failed);
+    } else {
+        printf("%11d %10.0f %9.1f %9.1f %9.1f %9.1f %7d\n", concurrency,
+               done / elapsed_s, all[done / 2], all[(int) (done * 0.99)],
+               all[done - 1], elapsed_s * 1e3, failed);
+    }
+    free(all);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 5) {
+        fprintf(stderr, "usage: %s SOCKET REQUESTS CONC[,CONC...] COMMAND\n",
+                argv[0]);
+        return 2;
+    }
+    const char *path = argv[1];
+    int requests = atoi(argv[2]);
+    char command[1024];
+    snprintf(command, sizeof(command), "%s\n", argv[4]);
+
+    printf("%11s %10s %9s %9s %9s %9s %7s\n", "concurrency", "req/s",
+           "p50(us)", "p99(us)", "max(us)", "total(ms)", "failed");
+    for (char *c = strtok(argv[3], ","); c != NULL; c = strtok(NULL, ",")) {
+        run_level(path, command, requests, atoi(c));
+    }
+    return 0;
+}
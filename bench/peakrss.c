@@ -0,0 +1,42 @@
+// peakrss [-c] CMD [ARGS...]: runs CMD and prints its peak RSS in KiB, or
+// with -c its voluntary and involuntary context switches. Forked from this
+// small process, so the child does not inherit the high-water mark of a
+// big parent (a fork from python reports python's own RSS).
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+int main(int argc, char *argv[]) {
+    struct rusage ru;
+    int status;
+    int switches = argc > 1 && strcmp(argv[1], "-c") == 0;
+
+    if (switches) {
+        argv++;
+        argc--;
+    }
+    if (argc < 2) {
+        fprintf(stderr, "usage: peakrss [-c] CMD [ARGS...]\n");
+        return 2;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(null, 1);
+        execvp(argv[1], &argv[1]);
+        _exit(127);
+    }
+    if (pid < 0 || wait4(pid, &status, 0, &ru) < 0) {
+        perror("peakrss");
+        return 1;
+    }
+    if (switches) {
+        printf("%ld %ld\n", ru.ru_nvcsw, ru.ru_nivcsw);
+    } else {
+        printf("%ld\n", ru.ru_maxrss);
+    }
+    return 0;
+}
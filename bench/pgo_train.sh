@@ -0,0 +1,35 @@
+#!/bin/bash
+# Training run for `make -C src profile` (PGO): the regression tests plus
+# the workloads of the bench_*.sh scripts, on the instrumented binary.
+# Usage: bench/pgo_train.sh MYSH
+set -e
+MYSH=$(realpath "$1")
+cd "$(dirname "$0")"
+. ./common.sh
+
+(cd ../test-cases
+ for t in T_*.txt; do
+     case $t in *_result*) continue ;; esac
+     timeout 60 "$MYSH" < "$t" > /dev/null 2>&1 || true
+ done)
+
+for p in 1 2 3; do
+    gen_program "$WORK/echo$p" 200
+    gen_program "$WORK/set$p" 200 "set v$p x$p"
+    printf 'repeat 200\nset l%s $v%s\nif $v%s == x%s\necho $v%s\nend\nend\n' \
+        "$p" "$p" "$p" "$p" "$p" > "$WORK/loop$p"
+done
+printf 'echo outer\nsource %s/echo1\necho done\n' "$WORK" > "$WORK/nest"
+{
+    for round in $(seq 1 20); do
+        for policy in FCFS SJF RR RR30 AGING; do
+            echo "exec $WORK/echo1 $WORK/set2 $WORK/loop3 $policy"
+        done
+        echo "exec $WORK/set1 $WORK/echo2 $WORK/loop2 RR MT"
+        echo "exec $WORK/nest $WORK/set3 RR"
+        echo "exec $WORK/loop1 $WORK/set1 RR ISOLATE"
+        echo "set a b; print a; echo \$a"
+    done
+    echo quit
+} > "$WORK/train"
+"$MYSH" < "$WORK/train" > /dev/null
@@ -0,0 +1,82 @@
+// Times EDF dispatch on the shell's ready queue at large queue sizes.
+// Usage: rqbench [DISPATCHES]
+// For each queue size N, fills the queue with N programs with random
+// deadlines, then times DISPATCHES dispatches: pop the earliest, push it
+// back with a later deadline, as the EDF loop does after every slice. The
+// same pattern on the score-sorted list AGING uses shows what a list
+// ordered by deadline would cost.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ready_queue.h"
+#include "procinfo.h"
+
+// ready_queue.c reports AGING score changes to ps; nothing to report here.
+void procinfo_publish(const PCB *pcb, ProcState state, int worker) {
+    (void)pcb; (void)state; (void)worker;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double run_edf(PCB *pcbs, int n, long dispatches) {
+    for (int i = 0; i < n; i++) {
+        pcbs[i].deadline = rand() % (4 * n);
+        ready_queue_push_deadline(&pcbs[i]);
+    }
+    double t0 = now_ns();
+    for (long d = 0; d < dispatches; d++) {
+        PCB *p = ready_queue_pop_earliest();
+        p->deadline += 1 + rand() % (4 * n);
+        ready_queue_push_deadline(p);
+    }
+    double t = (now_ns() - t0) / dispatches;
+    while (ready_queue_pop_earliest() != NULL) {
+    }
+    return t;
+}
+
+static double run_sorted(PCB *pcbs, int n, long dispatches) {
+    for (int i = 0; i < n; i++) {
+        pcbs[i].job_length_score = rand() % (4 * n);
+        ready_queue_insert_sorted(&pcbs[i]);
+    }
+    double t0 = now_ns();
+    for (long d = 0; d < dispatches; d++) {
+        PCB *p = ready_queue_pop_head();
+        p->job_length_score += 1 + rand() % (4 * n);
+        ready_queue_insert_sorted(p);
+    }
+    double t = (now_ns() - t0) / dispatches;
+    while (ready_queue_pop_head() != NULL) {
+    }
+    return t;
+}
+
+int main(int argc, char **argv) {
+    long dispatches = argc > 1 ? atol(argv[1]) : 200000;
+    static const int sizes[] = {3, 30, 300, 3000, 30000};
+
+    printf("%8s %14s %14s\n", "queued", "EDF heap", "sorted list");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int n = sizes[s];
+        PCB *pcbs = calloc(n, sizeof(PCB));
+        if (pcbs == NULL) {
+            return 1;
+        }
+        srand(1);
+        double edf = run_edf(pcbs, n, dispatches);
+        srand(1);
+        // The list walks half the queue per insert; keep its run short.
+        long list_dispatches = n > 300 ? dispatches / (n / 300) : dispatches;
+        double sorted = run_sorted(pcbs, n, list_dispatches);
+        printf("%8d %11.1f ns %11.1f ns\n", n, edf, sorted);
+        free(pcbs);
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+// Checks the SIMD tokenizers against the scalar reference, then times them.
+// Usage: tokcheck [-f FUZZ_CASES] FILE...
+// Every line of every FILE (with and without its newline) and FUZZ_CASES
+// random commands, built mostly from delimiters and placed at every
+// alignment, must give the same tokens, stop offset and overflow flag,
+// including ';' chains and a small token limit.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "tokenizer.h"
+
+#define MAX_TOKENS 100
+#define MAX_LINE 4096
+
+static const char *impl_names[] = {"scalar", "sse2", "avx2"};
+#define IMPLS 3
+
+static char **lines;
+static int line_count, line_cap;
+
+static void add_line(const char *s, size_t len) {
+    if (line_count == line_cap) {
+        line_cap = line_cap ? line_cap * 2 : 1024;
+        lines = realloc(lines, line_cap * sizeof(char *));
+    }
+    lines[line_count] = malloc(len + 1);
+    memcpy(lines[line_count], s, len);
+    lines[line_count][len] = '\0';
+    line_count++;
+}
+
+// Compare every implementation with the scalar one on inp, following the
+// ';' chain the way parseInput does. Returns the number of mismatches.
+static int check(const char *inp, int max) {
+    TokenizeFn ref = tokenize_impl("scalar");
+    int bad = 0;
+
+    for (int k = 1; k < IMPLS; k++) {
+        TokenizeFn fn = tokenize_impl(impl_names[k]);
+        if (fn == NULL) continue;
+        const char *p = inp;
+        for (;;) {
+            Token a[MAX_TOKENS], b[MAX_TOKENS];
+            int stop_a, stop_b, over_a, over_b;
+            int na = ref(p, a, max, &stop_a, &over_a);
+            int nb = fn(p, b, max, &stop_b, &over_b);
+            int same = na == nb && stop_a == stop_b && over_a == over_b;
+            for (int i = 0; same && i < na; i++) {
+                same = a[i].start == b[i].start && a[i].len == b[i].len;
+            }
+            if (!same) {
+                fprintf(stderr, "%s differs on \"%s\" (max %d): %d/%d tokens, "
+                        "stop %d/%d, overflow %d/%d\n", impl_names[k], p, max,
+                        na, nb, stop_a, stop_b, over_a, over_b);
+                bad++;
+                break;
+            }
+            if (p[stop_a] != ';') break;
+            p += stop_a + 1;
+        }
+    }
+    return bad;
+}
+
+static int check_aligned(const char *s, int max) {
+    static char buf[MAX_LINE + 64] __attribute__((aligned(64)));
+    size_t len = strlen(s);
+    int bad = 0;
+    if (len > MAX_LINE) return 0;
+    for (int off = 0; off < 32; off++) {
+        memcpy(buf + off, s, len + 1);
+        bad += check(buf + off, max);
+    }
+    return bad;
+}
+
+static void fuzz_line(char *out, int len) {
+    static const char alphabet[] = "  \t\t;;##\n\r\v\fab$_=xyz0\x80\xff";
+    for (int i = 0; i < len; i++) {
+        out[i] = alphabet[rand() % (sizeof(alphabet) - 1)];
+    }
+    out[len] = '\0';
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char *argv[]) {
+    int fuzz = 100000, bad = 0, i;
+    char line[MAX_LINE + 2];
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            fuzz = atoi(argv[++i]);
+            continue;
+        }
+        FILE *f = fopen(argv[i], "r");
+        if (f == NULL) {
+            perror(argv[i]);
+            return 1;
+        }
+        while (fgets(line, sizeof(line), f) != NULL) {
+            add_line(line, strlen(line));
+            line[strcspn(line, "\n")] = '\0';
+            add_line(line, strlen(line));
+        }
+        fclose(f);
+    }
+    int file_lines = line_count;
+
+    for (i = 0; i < line_count; i++) {
+        bad += check_aligned(lines[i], MAX_TOKENS) + check_aligned(lines[i], 3);
+    }
+    srand(1);
+    for (i = 0; i < fuzz; i++) {
+        fuzz_line(line, rand() % 200);
+        bad += check_aligned(line, MAX_TOKENS) + check_aligned(line, 3);
+    }
+    printf("checked %d file lines and %d fuzz cases: %d mismatches\n",
+           file_lines, fuzz, bad);
+
+    // Timing: the file lines, as parseInput sees them.
+    if (file_lines > 0) {
+        int rounds = 2000000 / file_lines + 1;
+        for (int k = 0; k < IMPLS; k++) {
+            TokenizeFn fn = tokenize_impl(impl_names[k]);
+            Token t[MAX_TOKENS];
+            int stop, over;
+            long sink = 0;
+            if (fn == NULL) {
+                printf("%-8s unavailable\n", impl_names[k]);
+                continue;
+            }
+            double start = now_ns();
+            for (int r = 0; r < rounds; r++) {
+                for (i = 0; i < file_lines; i++) {
+                    sink += fn(lines[i], t, MAX_TOKENS, &stop, &over) + stop;
+                }
+            }
+            double ns = (now_ns() - start) / ((double)rounds * file_lines);
+            printf("%-8s %8.1f ns/line (%ld)\n", impl_names[k], ns, sink & 1);
+        }
+    }
+    return bad != 0;
+}
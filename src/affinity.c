@@ -0,0 +1,105 @@
+#define _GNU_SOURCE             // CPU_SET, pthread_setaffinity_np, getcpu
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#ifdef HAVE_LIBNUMA
+#include <numa.h>
+#endif
+
+#include "affinity.h"
+
+static int cpu_list[CPU_SETSIZE];
+static int cpu_count = 0;       // 0 means workers are not pinned
+
+int affinity_set_cpu_list(const char *list) {
+    int count = 0;
+    const char *p = list;
+
+    while (*p != '\0') {
+        char *end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        if (end == p || first < 0) {
+            return -1;
+        }
+        p = end;
+        if (*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first) {
+                return -1;
+            }
+            p = end;
+        }
+        if (last >= CPU_SETSIZE || count + (last - first + 1) > CPU_SETSIZE) {
+            return -1;
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            cpu_list[count++] = (int) cpu;
+        }
+        if (*p == ',') {
+            p++;
+        } else if (*p != '\0') {
+            return -1;
+        }
+    }
+
+    cpu_count = count;
+    return 0;
+}
+
+// Workers take the listed CPUs round-robin.
+int affinity_cpu_for_worker(int worker_id) {
+    if (cpu_count == 0) {
+        return -1;
+    }
+    return cpu_list[worker_id % cpu_count];
+}
+
+int affinity_pin_self(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+int affinity_current_cpu(void) {
+    return sched_getcpu();
+}
+
+int affinity_current_node(void) {
+    unsigned int cpu, node;
+    if (getcpu(&cpu, &node) != 0) {
+        return -1;
+    }
+    return (int) node;
+}
+
+void *affinity_alloc_local(size_t size) {
+    void *p;
+#ifdef HAVE_LIBNUMA
+    if (numa_available() >= 0) {
+        return numa_alloc_local(size);  // fresh pages, already zeroed
+    }
+#endif
+    p = malloc(size);
+    if (p != NULL) {
+        memset(p, 0, size);     // first touch from the calling thread
+    }
+    return p;
+}
+
+void affinity_free_local(void *p, size_t size) {
+    if (p == NULL) {
+        return;
+    }
+#ifdef HAVE_LIBNUMA
+    if (numa_available() >= 0) {
+        numa_free(p, size);
+        return;
+    }
+#endif
+    (void) size;
+    free(p);
+}
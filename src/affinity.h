@@ -0,0 +1,19 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <stddef.h>
+
+// Worker placement for the MT scheduler (mysh --cpus LIST).
+int affinity_set_cpu_list(const char *list); // "0,2,4-7"; 0 on success
+int affinity_cpu_for_worker(int worker_id);  // -1 when unpinned
+int affinity_pin_self(int cpu);              // 0 on success
+int affinity_current_cpu(void);
+int affinity_current_node(void);             // -1 when unknown
+
+// Memory on the calling thread's NUMA node. Without libnuma this is plain
+// malloc, which the kernel's first-touch policy still places locally once
+// the (pinned) caller writes to it.
+void *affinity_alloc_local(size_t size);
+void affinity_free_local(void *p, size_t size);
+
+#endif
@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "checkpoint.h"
+#include "shellmemory.h"
+#include "scriptload.h"
+#include "control.h"
+#include "intern.h"
+
+#define CHECKPOINT_BUF (64 * 1024)
+
+// Records are small (a line, a var), so they are packed into one buffer
+// and written out a full buffer at a time instead of through stdio, whose
+// per-call locking is most of the cost of a snapshot.
+typedef struct {
+    int fd;
+    int failed;
+    size_t len;
+    char buf[CHECKPOINT_BUF];
+} Writer;
+
+static void flush(Writer *w) {
+    size_t done = 0;
+    while (!w->failed && done < w->len) {
+        ssize_t n = write(w->fd, w->buf + done, w->len - done);
+        if (n < 0 && errno != EINTR) {
+            w->failed = 1;
+        } else if (n > 0) {
+            done += n;
+        }
+    }
+    w->len = 0;
+}
+
+static void put(Writer *w, const void *data, size_t size) {
+    const char *p = data;
+    while (size > 0 && !w->failed) {
+        if (w->len == sizeof(w->buf)) {
+            flush(w);
+        }
+        size_t n = sizeof(w->buf) - w->len;
+        if (n > size) {
+            n = size;
+        }
+        memcpy(w->buf + w->len, p, n);
+        w->len += n;
+        p += n;
+        size -= n;
+    }
+}
+
+static void put_str(Writer *w, const char *s) {
+    uint32_t len = strlen(s);
+    put(w, &len, sizeof(len));
+    put(w, s, len);
+}
+
+static int put_var(const char *var, const char *value, void *arg) {
+    Writer *w = arg;
+    put(w, "V", 1);
+    put_str(w, var);
+    put_str(w, value);
+    return w->failed;
+}
+
+static int put_prog(Writer *w, PCB *pcb, long clock) {
+    CheckpointProg rec;
+
+    // Its code, parent and private variables live outside the snapshot.
+    if (pcb->vars != NULL || pcb->parent != NULL || pcb->children_alive > 0) {
+        fprintf(stderr, "checkpoint: program %d is isolated or nested\n", pcb->pid);
+        return 0;
+    }
+    memset(&rec, 0, sizeof(rec));
+    rec.count = pcb->end - pcb->start + 1;
+    rec.pc = pcb->pc - pcb->start;
+    rec.job_time = pcb->job_time;
+    rec.job_length_score = pcb->job_length_score;
+    rec.loop_depth = pcb->loop_depth;
+    for (int i = 0; i < pcb->loop_depth; i++) {
+        rec.loop_remaining[i] = pcb->loop_remaining[i];
+    }
+    rec.deadline_own = pcb->deadline_own;
+    rec.deadline = pcb->deadline == LONG_MAX ? INT64_MAX
+                                             : (int64_t)(pcb->deadline - clock);
+    rec.quota = pcb->quota;
+    rec.used = pcb->used;
+    put(w, "P", 1);
+    put(w, &rec, sizeof(rec));
+    for (int i = pcb->start; i <= pcb->end; i++) {
+        CodeLine *code = mem_get_code(i);
+        // Lines the program has not reached yet are copied in now; the
+        // restored program has no text to load them from.
+        if (code->line == mem_unloaded_line && pcb->map != NULL) {
+            script_map_fill(pcb->map, i);
+        }
+        put_str(w, code->line != NULL ? code->line : "");
+    }
+    return !w->failed;
+}
+
+int checkpoint_write(const char *path, PCB *pcbs[], int count,
+                     SchedulePolicy policy, int slice_ms, long clock) {
+    char tmp[4200];
+    CheckpointHeader h = { CHECKPOINT_MAGIC, CHECKPOINT_VERSION, policy, slice_ms };
+    Writer *w = malloc(sizeof(Writer));
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    if (w == NULL || (w->fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+        free(w);
+        return -1;
+    }
+    w->failed = 0;
+    w->len = 0;
+
+    put(w, &h, sizeof(h));
+    int ok = mem_for_each_var(put_var, w) == 0;
+    for (int i = 0; ok && i < count; i++) {
+        ok = put_prog(w, pcbs[i], clock);
+    }
+    put(w, "E", 1);
+    flush(w);
+    ok = ok && !w->failed;
+    ok = (close(w->fd) == 0) && ok;
+    free(w);
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+typedef struct {
+    const char *p;
+    const char *end;
+} Cursor;
+
+static int take(Cursor *c, void *out, size_t n) {
+    if ((size_t)(c->end - c->p) < n) {
+        return 0;
+    }
+    memcpy(out, c->p, n);
+    c->p += n;
+    return 1;
+}
+
+static int take_str(Cursor *c, const char **s, uint32_t *len) {
+    if (!take(c, len, sizeof(*len)) || (size_t)(c->end - c->p) < *len) {
+        return 0;
+    }
+    *s = c->p;
+    c->p += *len;
+    return 1;
+}
+
+static int prog_valid(const CheckpointProg *rec) {
+    return rec->count > 0 && rec->count <= MEM_SIZE
+        && rec->pc >= 0 && rec->pc < rec->count
+        && rec->loop_depth >= 0 && rec->loop_depth <= PCB_LOOP_DEPTH;
+}
+
+// What a walk over the records after the header does. Programs are loaded
+// before any variable is set, so a snapshot that does not fit changes
+// nothing.
+enum { WALK_CHECK, WALK_PROGS, WALK_VARS };
+
+// WALK_CHECK only checks that the snapshot is complete and counts its
+// programs; WALK_PROGS loads them into pcbs[].
+static int walk(Cursor c, int mode, PCB *pcbs[], int *count, long clock) {
+    int n = 0;
+    char tag = 0;
+
+    while (take(&c, &tag, 1) && tag != 'E') {
+        if (tag == 'V') {
+            const char *var, *value;
+            uint32_t var_len, value_len;
+            if (!take_str(&c, &var, &var_len) || !take_str(&c, &value, &value_len)) {
+                return -1;
+            }
+            if (mode == WALK_VARS) {
+                char *v = strndup(var, var_len);
+                char *val = strndup(value, value_len);
+                if (v != NULL && val != NULL) {
+                    mem_set_value(v, val);
+                }
+                free(v);
+                free(val);
+            }
+        } else if (tag == 'P') {
+            CheckpointProg rec;
+            char **lines = NULL;
+            int loaded = 0, ok = 1, apply = mode == WALK_PROGS;
+
+            if (!take(&c, &rec, sizeof(rec)) || !prog_valid(&rec)) {
+                return -1;
+            }
+            if (apply) {
+                lines = malloc(rec.count * sizeof(char *));
+                ok = lines != NULL;
+            }
+            for (int i = 0; ok && i < rec.count; i++) {
+                const char *s;
+                uint32_t len;
+                ok = take_str(&c, &s, &len);
+                if (ok && apply) {
+                    lines[loaded] = (char *)intern_n(s, len);
+                    ok = lines[loaded] != NULL;
+                    loaded += ok;
+                }
+            }
+            if (!ok) {
+                for (int i = 0; i < loaded; i++) {
+                    intern_release(lines[i]);
+                }
+                free(lines);
+                return -1;
+            }
+            if (apply) {
+                int start = mem_load_script(lines, rec.count);
+                if (start < 0) {
+                    for (int i = 0; i < loaded; i++) {
+                        intern_release(lines[i]);
+                    }
+                    free(lines);
+                    return -1;
+                }
+                free(lines);
+                int end = start + rec.count - 1;
+                PCB *pcb = control_compile(start, end) >= 0 ? make_pcb(start, end) : NULL;
+                if (pcb == NULL) {
+                    mem_cleanup_script(start, end);
+                    return -1;
+                }
+                pcb->pc = start + rec.pc;
+                pcb->job_time = rec.job_time;
+                pcb->job_length_score = rec.job_length_score;
+                pcb->loop_depth = rec.loop_depth;
+                for (int i = 0; i < rec.loop_depth; i++) {
+                    pcb->loop_remaining[i] = rec.loop_remaining[i];
+                }
+                if (rec.deadline != INT64_MAX) {
+                    pcb->deadline = clock + rec.deadline;
+                }
+                pcb->deadline_own = rec.deadline_own;
+                pcb->quota = rec.quota;
+                pcb->used = rec.used;
+                pcbs[n] = pcb;
+            }
+            n++;
+        } else {
+            return -1;
+        }
+    }
+    if (tag != 'E') {
+        return -1;
+    }
+    *count = n;
+    return 0;
+}
+
+// Frees what a failed WALK_PROGS loaded.
+static void unload(PCB *pcbs[], int n) {
+    for (int i = 0; i < n && pcbs[i] != NULL; i++) {
+        mem_cleanup_script(pcbs[i]->start, pcbs[i]->end);
+        pcb_free(pcbs[i]);
+    }
+}
+
+int checkpoint_read(const char *path, PCB ***pcbs, int *count,
+                    SchedulePolicy *policy, int *slice_ms, long clock) {
+    CheckpointHeader h;
+    struct stat st;
+    char *buf = NULL;
+    int rc = -1, n = 0;
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return -1;
+    }
+    if (fstat(fileno(f), &st) == 0 && st.st_size >= (off_t)sizeof(h)
+        && (buf = malloc(st.st_size)) != NULL
+        && fread(buf, 1, st.st_size, f) == (size_t)st.st_size) {
+        Cursor c = { buf, buf + st.st_size };
+        take(&c, &h, sizeof(h));
+        if (h.magic == CHECKPOINT_MAGIC && h.version == CHECKPOINT_VERSION
+            && h.policy >= POLICY_FCFS && h.policy <= POLICY_EDF
+            && h.slice_ms >= 0 && walk(c, WALK_CHECK, NULL, &n, clock) == 0) {
+            PCB **loaded = calloc(n > 0 ? n : 1, sizeof(PCB *));
+            if (loaded != NULL && walk(c, WALK_PROGS, loaded, &n, clock) == 0) {
+                walk(c, WALK_VARS, NULL, &n, clock);
+                *pcbs = loaded;
+                *count = n;
+                *policy = h.policy;
+                *slice_ms = h.slice_ms;
+                rc = 0;
+            } else if (loaded != NULL) {
+                unload(loaded, n);
+                free(loaded);
+            }
+        }
+    }
+    free(buf);
+    fclose(f);
+    return rc;
+}
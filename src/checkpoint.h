@@ -0,0 +1,60 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdint.h>
+
+#include "pcb.h"
+#include "scheduler.h"
+
+/*
+ * checkpoint FILE / restore FILE. A snapshot holds the shell variables and
+ * every queued program, in queue order: its code lines, pc, loop counters,
+ * scores, quota usage and deadline, plus the policy that was running it.
+ * Records are streamed one at a time through a fixed buffer, so taking a
+ * snapshot is one walk over the queue and the variables with no copy of
+ * them in memory. It is written to FILE.tmp and renamed over FILE, so a
+ * crash while writing leaves the previous snapshot intact. Native byte
+ * order and layout, like the .mshc images.
+ *
+ *   CheckpointHeader | 'V' var | ... | 'P' CheckpointProg lines | ... | 'E'
+ *
+ * A var is its name and value, a line its text, each as a uint32_t length
+ * followed by the bytes.
+ */
+#define CHECKPOINT_MAGIC 0x4b48534d     // "MSHK"
+#define CHECKPOINT_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int32_t policy;         // SchedulePolicy
+    int32_t slice_ms;       // exec ... TIMESLICE, 0 if none
+} CheckpointHeader;
+
+typedef struct {
+    int32_t count;          // code lines that follow
+    int32_t pc;             // relative to the first line
+    int32_t job_time;
+    int32_t job_length_score;
+    int32_t loop_depth;
+    int32_t loop_remaining[PCB_LOOP_DEPTH];
+    int32_t deadline_own;
+    int64_t deadline;       // instructions from now (< 0: late), INT64_MAX if none
+    Quota quota;
+    QuotaUsage used;
+} CheckpointProg;
+
+// Writes the snapshot of pcbs and the shell variables. clock is the
+// engine clock deadlines are counted on. 0 on success, -1 on error (with
+// a message on stderr for a program that cannot be saved).
+int checkpoint_write(const char *path, PCB *pcbs[], int count,
+                     SchedulePolicy policy, int slice_ms, long clock);
+
+// Reads a snapshot: loads its programs into code memory, sets its
+// variables and returns the programs in queue order in a malloc'd *pcbs,
+// their deadlines counted from clock. -1 if the file is not a complete
+// snapshot or its programs do not fit; nothing is changed then.
+int checkpoint_read(const char *path, PCB ***pcbs, int *count,
+                    SchedulePolicy *policy, int *slice_ms, long clock);
+
+#endif
@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+
+#include "control.h"
+#include "shell.h"
+
+// Split a copy of line into at most max words. Returns the word count, or
+// max + 1 if there were more.
+static int control_words(const char *line, char *buf, size_t bufsize,
+                         char *words[], int max) {
+    int n = 0;
+    char *p;
+
+    strncpy(buf, line, bufsize - 1);
+    buf[bufsize - 1] = '\0';
+    p = buf;
+    while (*p != '\0') {
+        while (isspace((unsigned char)*p)) *p++ = '\0';
+        if (*p == '\0') break;
+        if (n == max) return max + 1;
+        words[n++] = p;
+        while (*p != '\0' && !isspace((unsigned char)*p)) p++;
+    }
+    return n;
+}
+
+static CodeOp control_classify(const char *line, int *arg, int *ok) {
+    char buf[MAX_USER_INPUT];
+    char *words[5];
+    int n = control_words(line, buf, sizeof(buf), words, 4);
+
+    *ok = 1;
+    if (n == 0) {
+        return OP_CMD;
+    }
+    if (strcmp(words[0], "repeat") == 0) {
+        char *end;
+        long count = n == 2 ? strtol(words[1], &end, 10) : -1;
+        if (n != 2 || *end != '\0' || count < 0 || count > INT_MAX) {
+            *ok = 0;
+        }
+        *arg = (int)count;
+        return OP_REPEAT;
+    }
+    if (strcmp(words[0], "if") == 0) {
+        if (n != 4 || (strcmp(words[2], "==") != 0 && strcmp(words[2], "!=") != 0)) {
+            *ok = 0;
+        }
+        return OP_IF;
+    }
+    if (strcmp(words[0], "end") == 0) {
+        if (n != 1) {
+            *ok = 0;
+        }
+        return OP_END;
+    }
+    return OP_CMD;
+}
+
+int control_classify_line(const char *line, int *arg) {
+    int ok;
+    CodeOp op = control_classify(line, arg, &ok);
+    return ok ? (int)op : -1;
+}
+
+int control_compile(int start, int end) {
+    int open_at[CONTROL_MAX_NESTING];     // index of each open repeat/if
+    long saved_mult[CONTROL_MAX_NESTING]; // multiplier outside that block
+    long body_cmds[CONTROL_MAX_NESTING];  // commands inside that block
+    int depth = 0, loops = 0;
+    long mult = 1, cost = 0, cmds = 0;
+
+    for (int i = start; i <= end; i++) {
+        CodeLine *code = mem_get_code(i);
+        int ok;
+
+        if (code == NULL || code->line == NULL) continue;
+        code->op = control_classify(code->line, &code->arg, &ok);
+        if (!ok) return -1;
+
+        switch (code->op) {
+        case OP_CMD:
+            cost += mult;
+            if (cost > INT_MAX) cost = INT_MAX;
+            cmds++;
+            break;
+        case OP_REPEAT:
+        case OP_IF:
+            if (depth == CONTROL_MAX_NESTING) return -1;
+            if (code->op == OP_REPEAT && ++loops > PCB_LOOP_DEPTH) return -1;
+            open_at[depth] = i;
+            saved_mult[depth] = mult;
+            body_cmds[depth] = cmds;
+            depth++;
+            // Job length assumes an if body runs.
+            if (code->op == OP_REPEAT) {
+                mult *= code->arg;
+                if (mult > INT_MAX) mult = INT_MAX;
+            }
+            break;
+        case OP_END: {
+            if (depth == 0) return -1;
+            depth--;
+            CodeLine *opener = mem_get_code(open_at[depth]);
+            opener->target = i;
+            code->target = open_at[depth];
+            mult = saved_mult[depth];
+            if (opener->op == OP_REPEAT) {
+                loops--;
+                // A loop with no commands in it would spin without ever
+                // counting against the quantum, so it is skipped.
+                if (cmds == body_cmds[depth]) opener->arg = 0;
+            }
+            break;
+        }
+        }
+    }
+
+    if (depth != 0) return -1;
+    return (int)cost;
+}
+
+// $NAME expands like echo: unset variables are the empty string.
+static int control_condition(const char *line) {
+    char buf[MAX_USER_INPUT];
+    char *words[5];
+    char *vals[2];
+    int result;
+
+    control_words(line, buf, sizeof(buf), words, 4);
+    for (int i = 0; i < 2; i++) {
+        char *w = words[i == 0 ? 1 : 3];
+        vals[i] = w[0] == '$' ? mem_get_value(w + 1) : strdup(w);
+    }
+    result = strcmp(vals[0] ? vals[0] : "", vals[1] ? vals[1] : "") == 0;
+    if (words[2][0] == '!') result = !result;
+    free(vals[0]);
+    free(vals[1]);
+    return result;
+}
+
+int control_step(PCB *pcb, CodeLine *code) {
+    switch (code->op) {
+    case OP_REPEAT:
+        if (code->arg <= 0) {
+            pcb->pc = code->target + 1;
+            return 0;
+        }
+        pcb->loop_remaining[pcb->loop_depth++] = code->arg;
+        pcb->pc++;
+        return 0;
+    case OP_IF:
+        pcb->pc = control_condition(code->line) ? pcb->pc + 1 : code->target + 1;
+        return 0;
+    case OP_END:
+        if (mem_get_code(code->target)->op == OP_REPEAT) {
+            if (--pcb->loop_remaining[pcb->loop_depth - 1] > 0) {
+                pcb->pc = code->target + 1;
+                return 1;
+            }
+            pcb->loop_depth--;
+        }
+        pcb->pc++;
+        return 0;
+    default:
+        pcb->pc++;
+        return 0;
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef CONTROL_H
+#define CONTROL_H
+
+#include "pcb.h"
+#include "shellmemory.h"
+
+/*
+ * Script control flow, available in programs run by exec/source:
+ *     repeat N            if A == B           (or A != B; $VAR expands)
+ *         ...                 ...
+ *     end                 end
+ * Loaded lines stay in shell_code once; the compile pass links each
+ * repeat/if with its end so the pc jumps instead of storing unrolled text.
+ * Control lines are not counted as instructions for scheduling quanta.
+ */
+
+#define CONTROL_MAX_NESTING 64   // repeat and if together
+
+// The op a line compiles to, with a repeat's count in *arg, or -1 if it is
+// a malformed repeat/if/end line.
+int control_classify_line(const char *line, int *arg);
+
+// Links the control lines in [start, end]. Returns the number of command
+// instructions the script will execute (used as its job length), or -1 on
+// a syntax error.
+int control_compile(int start, int end);
+
+// Runs the control line at pcb->pc and moves pc to the next line to run.
+// Returns 1 if that was a jump back to the top of a repeat loop, which
+// counts as an instruction (see run_instruction), else 0.
+int control_step(PCB *pcb, CodeLine *code);
+
+#endif
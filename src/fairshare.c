@@ -0,0 +1,185 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "fairshare.h"
+#include "scheduler.h"
+
+// Pass advanced per instruction at weight 1; a batch of weight w advances
+// by STRIDE1 / w, so it is picked w times as often.
+#define STRIDE1 (1 << 16)
+
+typedef struct {
+    PCB *head;
+    PCB *tail;
+    int len;
+} RunList;
+
+typedef struct ShareGroup {
+    int weight;
+    uint64_t pass;
+    int members;    // programs that have not finished, plus the creator
+    int queued;     // on lists[]
+    int running;    // taken by share_take and not charged yet
+    // One list per worker for the programs it ran last (soft affinity, see
+    // scheduler.c), and one for programs with no worker yet.
+    RunList lists[MT_WORKERS + 1];
+    struct ShareGroup *next;
+} ShareGroup;
+
+#define SHARED_LIST MT_WORKERS
+
+// Programs spawned outside any batch land here; never freed.
+static ShareGroup default_group = { .weight = 1 };
+static ShareGroup *groups = &default_group;
+static uint64_t vtime = 0;      // pass of the batch picked last
+static int total_queued = 0;
+static int live_batches = 0;
+
+static void list_push(RunList *l, PCB *p) {
+    p->next = NULL;
+    if (l->tail != NULL) {
+        l->tail->next = p;
+    } else {
+        l->head = p;
+    }
+    l->tail = p;
+    l->len++;
+}
+
+static PCB *list_pop(RunList *l) {
+    PCB *p = l->head;
+    if (p != NULL) {
+        l->head = p->next;
+        if (l->head == NULL) {
+            l->tail = NULL;
+        }
+        p->next = NULL;
+        l->len--;
+    }
+    return p;
+}
+
+ShareGroup *share_group_new(int weight) {
+    ShareGroup *g = calloc(1, sizeof(ShareGroup));
+    if (g == NULL) {
+        return NULL;
+    }
+    if (weight < 1) weight = 1;
+    if (weight > SHARE_MAX_WEIGHT) weight = SHARE_MAX_WEIGHT;
+    g->weight = weight;
+    g->pass = vtime;
+    g->members = 1;
+    live_batches++;
+    g->next = groups;
+    groups = g;
+    return g;
+}
+
+void share_join(ShareGroup *g, PCB *pcb) {
+    if (g == NULL) {
+        g = &default_group;
+    }
+    if (g->members++ == 0) {
+        live_batches++;
+    }
+    pcb->group = g;
+}
+
+void share_leave(PCB *pcb) {
+    ShareGroup *g = pcb->group;
+    if (g != NULL) {
+        pcb->group = NULL;
+        share_group_release(g);
+    }
+}
+
+void share_group_release(ShareGroup *g) {
+    if (g == NULL || --g->members > 0) {
+        return;
+    }
+    live_batches--;
+    if (g == &default_group) {
+        return;
+    }
+    for (ShareGroup **link = &groups; *link != NULL; link = &(*link)->next) {
+        if (*link == g) {
+            *link = g->next;
+            break;
+        }
+    }
+    free(g);
+}
+
+void share_enqueue(PCB *pcb) {
+    if (pcb->group == NULL) {
+        share_join(NULL, pcb);
+    }
+    ShareGroup *g = pcb->group;
+    // A batch that sat idle gets no credit for the time it was not
+    // runnable, or it would shut every other batch out until it caught up.
+    if (g->queued == 0 && g->running == 0 && g->pass < vtime) {
+        g->pass = vtime;
+    }
+    list_push(&g->lists[SHARED_LIST], pcb);
+    g->queued++;
+    total_queued++;
+}
+
+void share_requeue(PCB *pcb, int worker) {
+    ShareGroup *g = pcb->group;
+    int l = (worker >= 0 && worker < MT_WORKERS) ? worker : SHARED_LIST;
+    list_push(&g->lists[l], pcb);
+    g->queued++;
+    total_queued++;
+}
+
+int share_take(int worker, PCB *out[], int want) {
+    ShareGroup *best = NULL;
+    for (ShareGroup *g = groups; g != NULL; g = g->next) {
+        if (g->queued > 0 && (best == NULL || g->pass < best->pass)) {
+            best = g;
+        }
+    }
+    if (best == NULL) {
+        return 0;
+    }
+    if (best->pass > vtime) {
+        vtime = best->pass;
+    }
+
+    int n = 0;
+    while (n < want && best->lists[SHARED_LIST].len > 0) {
+        out[n++] = list_pop(&best->lists[SHARED_LIST]);
+    }
+    if (worker >= 0 && worker < MT_WORKERS) {
+        while (n < want && best->lists[worker].len > 0) {
+            out[n++] = list_pop(&best->lists[worker]);
+        }
+    }
+    for (int other = 0; other < MT_WORKERS && n < want; other++) {
+        while (n < want && best->lists[other].len > 0) {
+            out[n++] = list_pop(&best->lists[other]);
+        }
+    }
+    best->queued -= n;
+    best->running += n;
+    total_queued -= n;
+    return n;
+}
+
+void share_charge(PCB *pcb, int executed) {
+    ShareGroup *g = pcb->group;
+    if (executed < 1) {
+        executed = 1;   // a slice that parked at once still cost a dispatch
+    }
+    g->running--;
+    g->pass += (uint64_t)executed * (STRIDE1 / g->weight);
+}
+
+int share_queued(void) {
+    return total_queued;
+}
+
+int share_batches(void) {
+    return live_batches;
+}
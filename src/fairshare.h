@@ -0,0 +1,41 @@
+#ifndef FAIRSHARE_H
+#define FAIRSHARE_H
+
+#include "pcb.h"
+
+// Weighted fair sharing of the MT workers between exec batches. Each exec
+// from the prompt is one batch with a weight (exec ... WEIGHT N); a worker
+// first picks the batch that is furthest behind its share (stride
+// scheduling), then takes that batch's programs round robin. Programs
+// spawned by a running one join its batch. Every call below must be made
+// with the scheduler's rq_mutex held.
+
+#define SHARE_MAX_WEIGHT 100
+#define SHARE_SHARED -1     // worker argument: no affinity
+
+struct ShareGroup;
+
+// A new batch, held by the caller until share_group_release; it is freed
+// once that and all its programs are done.
+struct ShareGroup *share_group_new(int weight);
+void share_group_release(struct ShareGroup *g);
+// pcb belongs to g from now on (NULL: the default batch, weight 1).
+void share_join(struct ShareGroup *g, PCB *pcb);
+// pcb finished.
+void share_leave(PCB *pcb);
+
+// pcb became runnable: a new arrival, or woken after a wait.
+void share_enqueue(PCB *pcb);
+// pcb is runnable again after a slice on worker (SHARE_SHARED: anywhere).
+void share_requeue(PCB *pcb, int worker);
+// Up to want PCBs from the batch with the lowest pass: unstarted ones
+// first, then the ones worker ran last, then the other workers' ones.
+int share_take(int worker, PCB *out[], int want);
+// A slice taken by share_take ran executed instructions.
+void share_charge(PCB *pcb, int executed);
+// PCBs waiting on all batches.
+int share_queued(void);
+// Batches with programs left.
+int share_batches(void);
+
+#endif
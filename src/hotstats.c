@@ -0,0 +1,72 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "hotstats.h"
+
+#ifdef MYSH_STATS
+__thread HotStatBlock *hotstats_self = NULL;
+
+// Blocks are never freed: a worker's counts outlive it for the quit dump.
+static HotStatBlock *all_blocks = NULL;
+static pthread_mutex_t blocks_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+HotStatBlock *hotstats_register(void) {
+    HotStatBlock *b = aligned_alloc(64, sizeof(HotStatBlock));
+    if (b == NULL) return NULL;
+    for (int i = 0; i < HS_COUNT; i++) {
+        b->calls[i] = b->cycles[i] = 0;
+    }
+    pthread_mutex_lock(&blocks_mutex);
+    b->next = all_blocks;
+    all_blocks = b;
+    pthread_mutex_unlock(&blocks_mutex);
+    hotstats_self = b;
+    return b;
+}
+#endif
+
+static const char *stat_names[HS_COUNT] = {
+    [HS_PARSE] = "parse",
+    [HS_INTERPRET] = "interpret",
+    [HS_VAR_GET] = "var_get",
+    [HS_VAR_SET] = "var_set",
+    [HS_QUEUE_OP] = "queue_op",
+    [HS_SCHED_LOCK] = "sched_lock",
+    [HS_OUTPUT] = "output",
+};
+
+int hotstats_enabled(void) {
+#ifdef MYSH_STATS
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+void hotstats_print(FILE *out) {
+#ifdef MYSH_STATS
+    unsigned long long calls[HS_COUNT] = {0}, cycles[HS_COUNT] = {0};
+    int threads = 0;
+
+    pthread_mutex_lock(&blocks_mutex);
+    for (HotStatBlock *b = all_blocks; b != NULL; b = b->next) {
+        for (int i = 0; i < HS_COUNT; i++) {
+            calls[i] += __atomic_load_n(&b->calls[i], __ATOMIC_RELAXED);
+            cycles[i] += __atomic_load_n(&b->cycles[i], __ATOMIC_RELAXED);
+        }
+        threads++;
+    }
+    pthread_mutex_unlock(&blocks_mutex);
+
+    fprintf(out, "%-12s %12s %16s %10s\n", "stat", "calls", "cycles", "per call");
+    for (int i = 0; i < HS_COUNT; i++) {
+        fprintf(out, "%-12s %12llu %16llu %10llu\n", stat_names[i], calls[i],
+                cycles[i], calls[i] ? cycles[i] / calls[i] : 0);
+    }
+    fprintf(out, "threads %d\n", threads);
+#else
+    (void)stat_names;
+    fprintf(out, "stats: built without counters (make STATS=1)\n");
+#endif
+}
@@ -0,0 +1,65 @@
+#ifndef HOTSTATS_H
+#define HOTSTATS_H
+
+#include <stdio.h>
+
+// Hot-path counters and cycle timers, compiled in with `make STATS=1`
+// (-DMYSH_STATS). Without it the macros below expand to nothing. Each
+// thread counts into its own cache-line aligned block, so counting never
+// writes a line another thread touches; the stats command sums the blocks.
+typedef enum {
+    HS_PARSE = 0,       // parseInput tokenizing
+    HS_INTERPRET,       // interpreter, including the command it runs
+    HS_VAR_GET,         // mem_get_value
+    HS_VAR_SET,         // mem_set_value
+    HS_QUEUE_OP,        // every ready_queue_* operation, lock included
+    HS_SCHED_LOCK,      // scheduler rq_mutex: acquisitions, cycles waited
+    HS_OUTPUT,          // echo/print output
+    HS_COUNT
+} HotStat;
+
+#ifdef MYSH_STATS
+#include <stdint.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t hotstats_now(void) {
+    return __rdtsc();
+}
+#else
+#include <time.h>
+static inline uint64_t hotstats_now(void) {     // nanoseconds, not cycles
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#endif
+
+typedef struct HotStatBlock {
+    uint64_t calls[HS_COUNT];
+    uint64_t cycles[HS_COUNT];
+    struct HotStatBlock *next;
+} __attribute__((aligned(64))) HotStatBlock;
+
+extern __thread HotStatBlock *hotstats_self;
+HotStatBlock *hotstats_register(void);
+
+// Only the owning thread writes its block; relaxed stores keep a
+// concurrent stats read well-defined without a locked instruction.
+static inline void hotstats_add(HotStat s, uint64_t cycles) {
+    HotStatBlock *b = hotstats_self ? hotstats_self : hotstats_register();
+    if (b == NULL) return;
+    __atomic_store_n(&b->calls[s], b->calls[s] + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&b->cycles[s], b->cycles[s] + cycles, __ATOMIC_RELAXED);
+}
+
+#define HOTSTAT_START(t) uint64_t t = hotstats_now()
+#define HOTSTAT_STOP(s, t) hotstats_add((s), hotstats_now() - (t))
+#else
+#define HOTSTAT_START(t)
+#define HOTSTAT_STOP(s, t)
+#endif
+
+int hotstats_enabled(void);
+void hotstats_print(FILE *out);   // per-counter totals over all threads
+
+#endif
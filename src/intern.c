@@ -0,0 +1,182 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "intern.h"
+
+// Striped so threads interning different strings rarely share a lock.
+#define INTERN_SHARDS 16
+#define INTERN_MIN_BUCKETS 64
+
+typedef struct InternStr {
+    struct InternStr *next;     // bucket chain
+    unsigned hash;
+    int refs;
+    size_t len;
+    char str[];
+} InternStr;
+
+typedef struct {
+    pthread_mutex_t lock;
+    InternStr **buckets;
+    unsigned nbuckets;          // power of two
+    unsigned count;
+    long bytes;
+    long refs;
+    long copy_bytes;
+} __attribute__((aligned(64))) InternShard;
+
+static InternShard shards[INTERN_SHARDS] = {
+    [0 ... INTERN_SHARDS - 1] = { .lock = PTHREAD_MUTEX_INITIALIZER }
+};
+
+static unsigned str_hash(const char *s, size_t len) {
+    unsigned h = 2166136261u;   // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (unsigned char)s[i]) * 16777619u;
+    }
+    return h;
+}
+
+static InternStr *header_of(const char *s) {
+    return (InternStr *)(s - offsetof(InternStr, str));
+}
+
+static InternShard *shard_of(unsigned hash) {
+    // Buckets use the low bits, shards the high ones.
+    return &shards[hash >> 28 & (INTERN_SHARDS - 1)];
+}
+
+// Shard lock held.
+static InternStr *shard_find(InternShard *sh, const char *s, size_t len, unsigned hash) {
+    if (sh->nbuckets == 0) return NULL;
+    InternStr *e = sh->buckets[hash & (sh->nbuckets - 1)];
+    while (e != NULL && (e->hash != hash || e->len != len || memcmp(e->str, s, len) != 0)) {
+        e = e->next;
+    }
+    return e;
+}
+
+// Shard lock held. Keeps chains short; on allocation failure the table
+// just stays as it is.
+static void shard_grow(InternShard *sh) {
+    unsigned n = sh->nbuckets ? sh->nbuckets * 2 : INTERN_MIN_BUCKETS;
+    InternStr **buckets = calloc(n, sizeof(InternStr *));
+    if (buckets == NULL) return;
+    for (unsigned i = 0; i < sh->nbuckets; i++) {
+        InternStr *e = sh->buckets[i];
+        while (e != NULL) {
+            InternStr *next = e->next;
+            e->next = buckets[e->hash & (n - 1)];
+            buckets[e->hash & (n - 1)] = e;
+            e = next;
+        }
+    }
+    free(sh->buckets);
+    sh->buckets = buckets;
+    sh->nbuckets = n;
+}
+
+const char *intern_n(const char *s, size_t len) {
+    unsigned hash = str_hash(s, len);
+    InternShard *sh = shard_of(hash);
+
+    pthread_mutex_lock(&sh->lock);
+    InternStr *e = shard_find(sh, s, len, hash);
+    if (e != NULL) {
+        e->refs++;
+    } else {
+        if (sh->count >= sh->nbuckets) {
+            shard_grow(sh);
+        }
+        e = malloc(sizeof(InternStr) + len + 1);
+        if (e == NULL || sh->nbuckets == 0) {
+            free(e);
+            pthread_mutex_unlock(&sh->lock);
+            return NULL;
+        }
+        e->hash = hash;
+        e->refs = 1;
+        e->len = len;
+        memcpy(e->str, s, len);
+        e->str[len] = '\0';
+        e->next = sh->buckets[hash & (sh->nbuckets - 1)];
+        sh->buckets[hash & (sh->nbuckets - 1)] = e;
+        sh->count++;
+        sh->bytes += len + 1;
+    }
+    sh->refs++;
+    sh->copy_bytes += len + 1;
+    pthread_mutex_unlock(&sh->lock);
+    return e->str;
+}
+
+const char *intern(const char *s) {
+    return intern_n(s, strlen(s));
+}
+
+const char *intern_lookup(const char *s) {
+    size_t len = strlen(s);
+    unsigned hash = str_hash(s, len);
+    InternShard *sh = shard_of(hash);
+
+    pthread_mutex_lock(&sh->lock);
+    InternStr *e = shard_find(sh, s, len, hash);
+    if (e != NULL) {
+        e->refs++;
+        sh->refs++;
+        sh->copy_bytes += len + 1;
+    }
+    pthread_mutex_unlock(&sh->lock);
+    return e ? e->str : NULL;
+}
+
+void intern_release(const char *s) {
+    if (s == NULL) return;
+    InternStr *e = header_of(s);
+    InternShard *sh = shard_of(e->hash);
+
+    // References only change under the lock, so a lookup can never pick
+    // up a string that is being unlinked.
+    pthread_mutex_lock(&sh->lock);
+    sh->refs--;
+    sh->copy_bytes -= e->len + 1;
+    if (--e->refs == 0) {
+        InternStr **p = &sh->buckets[e->hash & (sh->nbuckets - 1)];
+        while (*p != e) p = &(*p)->next;
+        *p = e->next;
+        sh->count--;
+        sh->bytes -= e->len + 1;
+        free(e);
+    }
+    pthread_mutex_unlock(&sh->lock);
+}
+
+const char *intern_dup(const char *s) {
+    InternStr *e = header_of(s);
+    InternShard *sh = shard_of(e->hash);
+
+    pthread_mutex_lock(&sh->lock);
+    e->refs++;
+    sh->refs++;
+    sh->copy_bytes += e->len + 1;
+    pthread_mutex_unlock(&sh->lock);
+    return s;
+}
+
+unsigned intern_hash(const char *s) {
+    return header_of(s)->hash;
+}
+
+void intern_get_stats(InternStats *out) {
+    out->strings = out->refs = out->bytes = out->copy_bytes = 0;
+    for (int i = 0; i < INTERN_SHARDS; i++) {
+        pthread_mutex_lock(&shards[i].lock);
+        out->strings += shards[i].count;
+        out->refs += shards[i].refs;
+        out->bytes += shards[i].bytes;
+        out->copy_bytes += shards[i].copy_bytes;
+        pthread_mutex_unlock(&shards[i].lock);
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stddef.h>
+
+/*
+ * Global string interner. Equal strings share one immutable allocation, so
+ * two interned strings are equal exactly when their pointers are. Each
+ * intern/intern_n/intern_lookup that returns a string holds a reference
+ * to it, dropped with intern_release; the last release frees it. Safe to
+ * use from any thread.
+ */
+const char *intern(const char *s);
+const char *intern_n(const char *s, size_t len);
+// The interned copy of s if there is one (with a reference), else NULL.
+// Never allocates, so a miss is cheap.
+const char *intern_lookup(const char *s);
+const char *intern_dup(const char *s);  // one more reference to interned s
+void intern_release(const char *s);     // NULL is ignored
+unsigned intern_hash(const char *s);    // s must be interned
+
+typedef struct {
+    long strings;       // distinct strings alive
+    long refs;          // references to them
+    long bytes;         // their text, NULs included
+    long copy_bytes;    // what a separate copy per reference would take
+} InternStats;
+void intern_get_stats(InternStats *out);
+
+#endif
@@ -12,8 +12,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>              // tolower, isdigit
-#include <dirent.h>             // scandir
+#include <ctype.h>              // isdigit, isalpha
+#include <errno.h>              // strtol overflow
+#include <limits.h>             // INT_MAX, LONG_MAX
 #include <unistd.h>             // chdir
 #include <sys/stat.h>           // mkdir
 // for run:
@@ -25,6 +26,16 @@
 #include "pcb.h"
 #include "ready_queue.h"
 #include "scheduler.h"
+#include "server.h"
+#include "control.h"
+#include "quota.h"
+#include "hotstats.h"
+#include "procinfo.h"
+#include "scriptload.h"
+#include "progimage.h"
+#include "intern.h"
+#include "fairshare.h"
+#include "lscache.h"
 
 int badcommand() {
     printf("Unknown Command\n");
@@ -59,18 +70,31 @@ int cd(char *path);
 int source(char *script);
 int exec_cmd(char *args[], int arg_size);
 int run(char *args[], int args_size);
+int schedstats();
+int ps();
 int badcommandFileDoesNotExist();
 int badcommandExec();
 int badcommandExecPolicy();
 int badcommandExecDuplicate();
 int badcommandExecLoad();
+int badcommandExecServe();
 int parse_policy(char *policy_text, SchedulePolicy *out_policy);
-int load_and_schedule_programs(char *scripts[], int script_count, SchedulePolicy policy, int print_exec_load_error, int background_mode);
+int parse_number(char *text, long max, long *out);
+int load_and_schedule_programs(char *scripts[], int script_count, SchedulePolicy policy, int print_exec_load_error, int background_mode, int isolate, int weight, const long *deadlines);
+int export_var(char *var);
+int wait_children();
+int quota(char *args[], int args_size);
+int badcommandQuota();
+int compile(char *script);
+int stats();
+int edfstats();
+int checkpoint(char *args[], int args_size);
+int restore(char *path);
+int badcommandCheckpoint();
+int badcommandRestore();
 
 // Interpret commands and their arguments
 int interpreter(char *command_args[], int args_size) {
-    int i;
-
     // these bits of debug output were very helpful for debugging
     // the changes we made to the parser!
     debug("#args: %d\n", args_size);
@@ -86,10 +110,6 @@ int interpreter(char *command_args[], int args_size) {
         exit(1);
     }
 
-    for (i = 0; i < args_size; i++) {   // terminate args at newlines
-        command_args[i][strcspn(command_args[i], "\r\n")] = 0;
-    }
-
     if (strcmp(command_args[0], "help") == 0) {
         //help
         if (args_size != 1)
@@ -148,8 +168,58 @@ int interpreter(char *command_args[], int args_size) {
             return badcommand();
         return run(&command_args[1], args_size - 1);
 
+    } else if (strcmp(command_args[0], "export") == 0) {
+        if (args_size != 2)
+            return badcommand();
+        return export_var(command_args[1]);
+
+    } else if (strcmp(command_args[0], "quota") == 0) {
+        if (args_size != 1 && args_size != 3)
+            return badcommandQuota();
+        return quota(&command_args[1], args_size - 1);
+
+    } else if (strcmp(command_args[0], "wait") == 0) {
+        if (args_size != 1)
+            return badcommand();
+        return wait_children();
+
+    } else if (strcmp(command_args[0], "stats") == 0) {
+        if (args_size != 1)
+            return badcommand();
+        return stats();
+
+    } else if (strcmp(command_args[0], "compile") == 0) {
+        if (args_size != 2)
+            return badcommand();
+        return compile(command_args[1]);
+
+    } else if (strcmp(command_args[0], "ps") == 0) {
+        if (args_size != 1)
+            return badcommand();
+        return ps();
+
+    } else if (strcmp(command_args[0], "schedstats") == 0) {
+        if (args_size != 1)
+            return badcommand();
+        return schedstats();
+
+    } else if (strcmp(command_args[0], "edfstats") == 0) {
+        if (args_size != 1)
+            return badcommand();
+        return edfstats();
+
+    } else if (strcmp(command_args[0], "checkpoint") == 0) {
+        if (args_size != 2 && args_size != 4)
+            return badcommandCheckpoint();
+        return checkpoint(&command_args[1], args_size - 1);
+
+    } else if (strcmp(command_args[0], "restore") == 0) {
+        if (args_size != 2)
+            return badcommandRestore();
+        return restore(command_args[1]);
+
     } else if (strcmp(command_args[0], "exec") == 0) {
-        if (args_size < 3 || args_size > 6)
+        if (args_size < 3)  // exec_cmd checks the rest once flags are stripped
             return badcommandExec();
         return exec_cmd(&command_args[1], args_size - 1);
 
@@ -166,7 +236,17 @@ quit			Exits / terminates the shell with “Bye!”\n \
 set VAR STRING		Assigns a value to shell memory\n \
 print VAR		Displays the STRING assigned to VAR\n \
 source SCRIPT.TXT		Executes the file SCRIPT.TXT\n \
-exec p1 [p2] [p3] POLICY	Executes up to 3 programs\n ";
+exec p1 [p2] [p3] POLICY	Executes up to 3 programs\n \
+export VAR		Publishes an ISOLATE program's VAR to the shell\n \
+wait			In a script, waits for programs it started with exec ... #\n \
+quota [KIND N]		Shows or sets per-program limits for new programs\n \
+compile SCRIPT		Precompiles SCRIPT to SCRIPT.mshc for exec/source\n \
+ps			Lists running and queued programs\n \
+schedstats		Shows MT worker placement and counters\n \
+edfstats		Shows EDF deadline misses and lateness\n \
+checkpoint FILE [EVERY N]	Snapshots queued programs and variables to FILE\n \
+restore FILE		Resumes the programs and variables saved in FILE\n \
+stats			Shows interned strings and hot-path counters (make STATS=1)\n ";
     printf("%s\n", help_string);
     return 0;
 }
@@ -191,6 +271,43 @@ int badcommandExecLoad() {
     return 1;
 }
 
+int badcommandExecServe() {
+    printf("Bad command: exec # in serve mode\n");
+    return 1;
+}
+
+int badcommandCompile() {
+    printf("Bad command: compile\n");
+    return 1;
+}
+
+int badcommandQuota() {
+    printf("Bad command: quota\n");
+    return 1;
+}
+
+int badcommandCheckpoint() {
+    printf("Bad command: checkpoint\n");
+    return 1;
+}
+
+int badcommandRestore() {
+    printf("Bad command: restore\n");
+    return 1;
+}
+
+// A whole decimal argument in 1..max: "5x" or "" is not a number.
+int parse_number(char *text, long max, long *out) {
+    char *end;
+    errno = 0;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno != 0 || value < 1 || value > max) {
+        return 1;
+    }
+    *out = value;
+    return 0;
+}
+
 int parse_policy(char *policy_text, SchedulePolicy *out_policy) {
     // A2 1.2.2: Parse user policy tokens exactly as specified by the assignment.
     if (strcmp(policy_text, "FCFS") == 0) {
@@ -213,82 +330,143 @@ int parse_policy(char *policy_text, SchedulePolicy *out_policy) {
         *out_policy = POLICY_RR30;
         return 0;
     }
+    if (strcmp(policy_text, "EDF") == 0) {
+        *out_policy = POLICY_EDF;
+        return 0;
+    }
     return 1;
 }
 
-int load_and_schedule_programs(char *scripts[], int script_count, SchedulePolicy policy, int print_exec_load_error, int background_mode) {
+int load_and_schedule_programs(char *scripts[], int script_count, SchedulePolicy policy, int print_exec_load_error, int background_mode, int isolate, int weight, const long *deadlines) {
     // A2 1.2.2: Shared load/validation path used by both source and exec.
     // This keeps code loading, PCB creation, and queue setup policy-agnostic.
-    int starts[3];
-    int ends[3];
+    ScriptImage images[3];
     PCB *pcbs[3] = { NULL, NULL, NULL };
-    char line[MAX_USER_INPUT];
-
-    for (int i = 0; i < script_count; i++) {
-        starts[i] = -1;
-        ends[i] = -1;
+    VarSnapshot *snap = NULL;
+    VarScope *shared = NULL;
+    PCB *parent = scheduler_current_pcb();
+    struct ShareGroup *batch = NULL;
+    int loaded = 0;
+
+    // MT RR/RR30 from the prompt hands its programs to the workers as one
+    // share batch (see scheduler_admit). Nothing is queued until every
+    // script has loaded, so an exec that fails runs none of its programs.
+    int admit_batch = parent == NULL && scheduler_is_multithreaded()
+        && (policy == POLICY_RR || policy == POLICY_RR30);
+
+    // ISOLATE: every program reads one shared snapshot of the variables
+    // and keeps its own writes private until it exports them. Programs an
+    // isolated one sources or execs without ISOLATE use its scope, the
+    // way they would use shellmemory otherwise.
+    if (isolate) {
+        snap = mem_snapshot_take();
+        if (snap == NULL) {
+            return print_exec_load_error ? badcommandExecLoad() : 1;
+        }
+    } else if (parent != NULL) {
+        shared = parent->vars;
+    }
+    // The programs share the workers with other execs' as one batch of
+    // this weight (exec ... WEIGHT N), however many there are.
+    if (admit_batch) {
+        batch = scheduler_batch_new(weight);
     }
 
-    for (int i = 0; i < script_count; i++) {
-        FILE *p = fopen(scripts[i], "rt");
-        if (p == NULL) {
-            for (int j = 0; j < i; j++) {
-                mem_cleanup_script(starts[j], ends[j]);
-            }
-            if (print_exec_load_error) {
-                return badcommandExecLoad();
-            }
-            return 1;
-        }
+    script_load_begin(images, scripts, script_count);
 
-        while (fgets(line, MAX_USER_INPUT - 1, p) != NULL) {
-            int idx = mem_load_script_line(line);
-            if (idx < 0) {
-                fclose(p);
-                if (starts[i] >= 0) {
-                    mem_cleanup_script(starts[i], ends[i]);
-                }
-                for (int j = 0; j < i; j++) {
-                    mem_cleanup_script(starts[j], ends[j]);
+    for (; loaded < script_count; loaded++) {
+        ScriptImage *img = &images[loaded];
+        int start = 0, end = -1, cost = -1;
+
+        if (script_load_wait(img) == 0) {
+            if (img->count > 0) {
+                start = mem_load_script(img->lines, img->count);
+                end = start + img->count - 1;
+            }
+            if (start >= 0) {
+                img->count = 0;     // code memory owns the lines now
+                if (img->map != NULL) {
+                    script_map_attach(img->map, start);
                 }
-                if (print_exec_load_error) {
-                    return badcommandExecLoad();
+                // Link repeat/if/end; a script with unbalanced blocks fails
+                // to load. A compiled image comes linked already.
+                cost = img->cost >= 0 ? img->cost : control_compile(start, end);
+                if (cost < 0) {
+                    mem_cleanup_script(start, end);
                 }
-                return 1;
             }
-            if (starts[i] < 0) starts[i] = idx;
-            ends[i] = idx;
         }
+        if (cost >= 0) {
+            pcbs[loaded] = make_pcb(start, end);
+            if (pcbs[loaded] != NULL && shared != NULL) {
+                pcbs[loaded]->vars = mem_scope_share(shared);
+            } else if (pcbs[loaded] != NULL && snap != NULL
+                       && (pcbs[loaded]->vars = mem_scope_create(snap)) == NULL) {
+                pcb_free(pcbs[loaded]);
+                pcbs[loaded] = NULL;
+            }
+            if (pcbs[loaded] == NULL) {
+                mem_cleanup_script(start, end);
+            }
+        }
+        if (pcbs[loaded] == NULL) {
+            break;
+        }
+        if (deadlines != NULL) {
+            scheduler_set_deadline(pcbs[loaded], deadlines[loaded]);
+        }
+        // SJF/AGING job length counts executed instructions, so a loop
+        // weighs as much as its unrolled text would.
+        pcbs[loaded]->map = images[loaded].map;
+        images[loaded].map = NULL;
+        pcbs[loaded]->job_time = cost;
+        pcbs[loaded]->job_length_score = cost;
+    }
 
-        fclose(p);
+    for (int i = 0; i < script_count; i++) {
+        script_image_free(&images[i]);
+    }
+    mem_snapshot_release(snap);
 
-        if (starts[i] < 0) {
-            starts[i] = 0;
-            ends[i] = -1;
+    if (loaded < script_count) {
+        if (batch != NULL) {
+            scheduler_batch_release(batch);
+        }
+        for (int j = 0; j < loaded; j++) {
+            mem_cleanup_script(pcbs[j]->start, pcbs[j]->end);
+            pcb_free(pcbs[j]);
+        }
+        if (print_exec_load_error) {
+            return badcommandExecLoad();
         }
+        return 1;
     }
 
-    for (int i = 0; i < script_count; i++) {
-        pcbs[i] = make_pcb(starts[i], ends[i]);
-        if (pcbs[i] == NULL) {
-            for (int j = 0; j < i; j++) {
-                free(pcbs[j]);
-            }
-            for (int j = 0; j < script_count; j++) {
-                mem_cleanup_script(starts[j], ends[j]);
-            }
-            if (print_exec_load_error) {
-                return badcommandExecLoad();
-            }
-            return 1;
+    // Called from a running program: hand the new programs to the engine
+    // that is already running it instead of starting another one. source and
+    // a foreground exec block the caller until they finish; exec ... # does
+    // not (see the wait command).
+    if (parent != NULL) {
+        scheduler_spawn(parent, pcbs, script_count, !background_mode);
+        return 0;
+    }
+
+    if (batch != NULL) {
+        for (int i = 0; i < script_count; i++) {
+            procinfo_publish(pcbs[i], PS_READY, -1);
+            scheduler_admit(pcbs[i], batch, policy);
         }
+        scheduler_batch_release(batch);
     }
 
     // For AGING policy, use sorted insertion to order processes by job length
     // For other policies, use FIFO (add to tail)
-    for (int i = 0; i < script_count; i++) {
+    for (int i = 0; batch == NULL && i < script_count; i++) {
+        procinfo_publish(pcbs[i], PS_READY, -1);
         if (policy == POLICY_AGING) {
             ready_queue_insert_sorted(pcbs[i]);
+        } else if (policy == POLICY_EDF) {
+            ready_queue_push_deadline(pcbs[i]);
         } else {
             ready_queue_add_to_tail(pcbs[i]);
         }
@@ -304,6 +482,12 @@ int load_and_schedule_programs(char *scripts[], int script_count, SchedulePolicy
 
 int quit() {
     printf("Bye!\n");
+
+    // In service mode quit only ends the client's session.
+    if (server_is_serving()) {
+        server_close_current();
+        return 0;
+    }
     
     // For background mode, we need to wait for threads to finish
     // The scheduler_quit flag will be set when all jobs are done
@@ -314,22 +498,44 @@ int quit() {
         }
         scheduler_join_workers();
     }
+    if (hotstats_enabled()) {
+        fflush(stdout);
+        hotstats_print(stderr);
+    }
     exit(0);
 }
 
 int set(char *var, char *value) {
-    mem_set_value(var, value);
+    PCB *current = scheduler_current_pcb();
+
+    // Over a kill/demote quota the value is not stored; the scheduler
+    // acts on current->quota_hit once this command returns.
+    if (current != NULL && quota_charge_set(current, var, value) != 0) {
+        return 0;
+    }
+    if (mem_set_value(var, value) && current != NULL) {
+        current->used.vars++;
+    }
+    return 0;
+}
+
+int export_var(char *var) {
+    if (mem_export_value(var) != 0) {
+        printf("Variable does not exist\n");
+    }
     return 0;
 }
 
 int print(char *var) {
     char *value = mem_get_value(var);
+    HOTSTAT_START(t0);
     if (value) {
         printf("%s\n", value);
         free(value);
     } else {
         printf("Variable does not exist\n");
     }
+    HOTSTAT_STOP(HS_OUTPUT, t0);
     return 0;
 }
 
@@ -346,7 +552,9 @@ int echo(char *tok) {
         }
     }
 
+    HOTSTAT_START(t0);
     printf("%s\n", tok);
+    HOTSTAT_STOP(HS_OUTPUT, t0);
 
     // memory management technically optional for this assignment
     if (must_free) free(tok);
@@ -354,86 +562,13 @@ int echo(char *tok) {
     return 0;
 }
 
-// We can hide dotfiles in ls using either the filter operand to scandir,
-// or by checking the first character ourselves when we go to print
-// the names. That would work, and is less code, but this is more robust.
-// And this is also better since it won't allocate extra dirents.
-int ls_filter(const struct dirent *d) {
-    if (d->d_name[0] == '.') return 0;
-    return 1;
-}
-
-int ls_compare_char(char a, char b) {
-    // assumption: a,b are both either digits or letters.
-    // If this is not true, the characters will be effectively compared
-    // as ASCII when we do the lower_a - lower_b fallback.
-
-    // if both are digits, compare them
-    if (isdigit(a) && isdigit(b)) {
-        return a - b;
-    }
-    // if only a is a digit, then b isn't, so a wins.
-    if (isdigit(a)) {
-        return -1;
-    }
-
-    // lowercase both letters so we can compare their alphabetic position.
-    char lower_a = tolower(a), lower_b = tolower(b);
-    if (lower_a == lower_b) {
-        // a and b are the same letter, possibly in different cases.
-        // If they are really the same letter, this returns 0.
-        // Otherwise, it's negative if A was capital,
-        // and positive if B is capital.
-        return a - b;
-    }
-
-    // Otherwise, compare their alphabetic position by comparing
-    // them at a known case.
-    return lower_a - lower_b;
-}
-
-int ls_compare_str(const char *a, const char *b) {
-    // a simple strcmp implementation that uses ls_compare_char.
-    // We only check if *a is zero, since if *b is zero earlier,
-    // it would've been unequal to *a at that time and we would return.
-    // If *b is zero at the same point or later than *a, we'll exit the
-    // loop and return the correct value with the last comparison.
-
-    while (*a != '\0') {
-        int d = ls_compare_char(*a, *b);
-        if (d != 0) return d;
-        a++, b++;
-    }
-    return ls_compare_char(*a, *b);
-}
-
-int ls_compare(const struct dirent **a, const struct dirent **b) {
-    return ls_compare_str((*a)->d_name, (*b)->d_name);
-}
-
 int ls() {
-    // straight out of the man page examples for scandir
-    // alphasort uses strcoll instead of strcmp,
-    // so we have to implement our own comparator to match the ls spec.
-    // Note that the test cases weren't very picky about the specified order,
-    // so if you just used alphasort with scandir, you should have passed.
-    // This was intentional on our part.
-    struct dirent **namelist;
-    int n;
-
-    n = scandir(".", &namelist, NULL, ls_compare);
-    if (n == -1) {
+    // Sorted once per directory change and cached (see lscache.h); the
+    // listing goes out in one write.
+    if (lscache_list(stdout) != 0) {
         // something is catastrophically wrong, just give up.
         perror("my_ls couldn't scan the directory");
-        return 0;
-    }
-
-    for (size_t i = 0; i < n; ++i) {
-        printf("%s\n", namelist[i]->d_name);
-        free(namelist[i]);
     }
-    free(namelist);
-
     return 0;
 }
 
@@ -523,19 +658,68 @@ int source(char *script) {
     fclose(p);
 
     scripts[0] = script;
-    return load_and_schedule_programs(scripts, 1, POLICY_FCFS, 0, 0);
+    return load_and_schedule_programs(scripts, 1, POLICY_FCFS, 0, 0, 0, 1, NULL);
 }
 
 int exec_cmd(char *args[], int arg_size) {
-    // Detect background mode (#) and MT option - they can be in any order at the end
+    // Detect background mode (#), MT, ISOLATE, TIMESLICE MS and WEIGHT N options - they can be in any order at the end
     int background_mode = 0;
     int mt_detected = 0;
+    int isolate = 0;
+    int slice_ms = 0;
+    int weight = 1;
+    int weight_given = 0;
+    long deadlines[3];
+    int deadline_count = 0;
+
+    // DEADLINE D1 [D2] [D3]: EDF due times, one per program, in instructions
+    // from now. It comes after the policy; take it and its numbers out.
+    for (int i = 0; i < arg_size; i++) {
+        if (strcmp(args[i], "DEADLINE") != 0) {
+            continue;
+        }
+        while (i + 1 + deadline_count < arg_size && deadline_count < 3
+               && isdigit((unsigned char)args[i + 1 + deadline_count][0])) {
+            if (parse_number(args[i + 1 + deadline_count], INT_MAX,
+                             &deadlines[deadline_count]) != 0) {
+                return badcommandExec();
+            }
+            deadline_count++;
+        }
+        if (deadline_count == 0) {
+            return badcommandExec();
+        }
+        for (int j = i; j + deadline_count + 1 < arg_size; j++) {
+            args[j] = args[j + deadline_count + 1];
+        }
+        arg_size -= deadline_count + 1;
+        break;
+    }
     
-    // Strip both # and MT flags from the end, in any order
+    // Strip the option flags from the end, in any order
     while (arg_size > 0) {
-        if (strcmp(args[arg_size-1], "MT") == 0) {
+        if (arg_size >= 2 && strcmp(args[arg_size-2], "TIMESLICE") == 0) {
+            long ms;
+            if (parse_number(args[arg_size-1], INT_MAX, &ms) != 0) {
+                return badcommandExec();
+            }
+            slice_ms = (int)ms;
+            arg_size -= 2;
+        } else if (arg_size >= 2 && strcmp(args[arg_size-2], "WEIGHT") == 0) {
+            char *end;
+            long w = strtol(args[arg_size-1], &end, 10);
+            if (end == args[arg_size-1] || *end != '\0' || w < 1 || w > SHARE_MAX_WEIGHT) {
+                return badcommandExec();
+            }
+            weight = (int)w;
+            weight_given = 1;
+            arg_size -= 2;
+        } else if (strcmp(args[arg_size-1], "MT") == 0) {
             mt_detected = 1;
             arg_size--;
+        } else if (strcmp(args[arg_size-1], "ISOLATE") == 0) {
+            isolate = 1;
+            arg_size--;
         } else if (strcmp(args[arg_size-1], "#") == 0) {
             background_mode = 1;
             arg_size--;
@@ -556,6 +740,30 @@ int exec_cmd(char *args[], int arg_size) {
         return badcommandExecPolicy();
     }
 
+    if (deadline_count > 0 && (policy != POLICY_EDF || deadline_count != script_count)) {
+        return badcommandExec();
+    }
+
+    // WEIGHT shares the MT workers between execs (MT only runs RR/RR30).
+    // Single-threaded execs overlap too (exec ... # then another exec), but
+    // their programs share the one ready queue one by one; batches are not
+    // weighted there, so WEIGHT is refused rather than silently ignored.
+    if (weight_given && (!mt_detected || (policy != POLICY_RR && policy != POLICY_RR30))) {
+        return badcommandExec();
+    }
+
+    // TIMESLICE replaces the RR/RR30 instruction quantum; no other policy
+    // has one.
+    if (slice_ms > 0 && policy != POLICY_RR && policy != POLICY_RR30) {
+        return badcommandExec();
+    }
+
+    // In serve mode stdout is the connection being served, so a background
+    // job would outlive its request and write into other clients' replies.
+    if (background_mode && server_is_serving() && scheduler_current_pcb() == NULL) {
+        return badcommandExecServe();
+    }
+
     for (int i = 0; i < script_count; i++) {
         for (int j = i + 1; j < script_count; j++) {
             if (strcmp(args[i], args[j]) == 0) {
@@ -564,14 +772,21 @@ int exec_cmd(char *args[], int arg_size) {
         }
     }
 
-    // Enable MT only if flag is present in THIS exec
-    if (mt_detected) {
-        scheduler_enable_multithreaded();
-    } else {
-        scheduler_disable_multithreaded();
+    // A nested exec joins the engine that runs its caller, so it leaves the
+    // running configuration alone.
+    if (scheduler_current_pcb() == NULL) {
+        scheduler_set_time_slice_ms(slice_ms);
+
+        // Enable MT only if flag is present in THIS exec
+        if (mt_detected) {
+            scheduler_enable_multithreaded();
+        } else {
+            scheduler_disable_multithreaded();
+        }
     }
 
-    return load_and_schedule_programs(args, script_count, policy, 1, background_mode);
+    return load_and_schedule_programs(args, script_count, policy, 1, background_mode, isolate, weight,
+                                      deadline_count > 0 ? deadlines : NULL);
 }
 
 int run(char *args[], int arg_size) {
@@ -610,3 +825,123 @@ int run(char *args[], int arg_size) {
 
     return 0;
 }
+
+int quota(char *args[], int args_size) {
+    // quota: show the limits for new programs. quota KIND N / quota action A
+    // sets one of them (see quota.h).
+    if (args_size == 0) {
+        quota_print();
+        return 0;
+    }
+    if (quota_configure(args[0], args[1]) != 0) {
+        return badcommandQuota();
+    }
+    return 0;
+}
+
+int wait_children() {
+    // Only meaningful inside a script: block it until the programs it
+    // started with exec ... # have finished.
+    PCB *current = scheduler_current_pcb();
+    if (current != NULL) {
+        scheduler_wait_children(current);
+    }
+    return 0;
+}
+
+int schedstats() {
+    WorkerStats ws;
+    for (int i = 0; i < MT_WORKERS; i++) {
+        if (!scheduler_get_worker_stats(i, &ws)) {
+            printf("worker %d: not running\n", i);
+            continue;
+        }
+        printf("worker %d: cpu %d%s node %d slices %ld instructions %ld migrations %ld"
+               " spin-hits %ld parks %ld\n",
+               ws.id, ws.cpu, ws.pinned ? " (pinned)" : "", ws.node,
+               ws.slices, ws.instructions, ws.migrations, ws.spin_hits, ws.parks);
+    }
+    printf("wakeups %ld\n", scheduler_get_wakeups());
+    return 0;
+}
+
+int edfstats() {
+    DeadlineStats ds;
+    scheduler_get_deadline_stats(&ds);
+    printf("EDF: %ld finished, %ld missed their deadline", ds.finished, ds.missed);
+    if (ds.missed > 0) {
+        printf(", lateness max %ld total %ld", ds.max_lateness, ds.total_lateness);
+    }
+    printf("\n");
+    return 0;
+}
+
+// checkpoint FILE [EVERY N] | checkpoint OFF. Inside a program the
+// snapshot is taken when its slice ends; EVERY N repeats it every N
+// instructions of the engine.
+int checkpoint(char *args[], int args_size) {
+    long every = 0;
+
+    if (args_size == 1 && strcmp(args[0], "OFF") == 0) {
+        return scheduler_checkpoint(NULL, 0);
+    }
+    if (args_size == 3) {
+        if (strcmp(args[1], "EVERY") != 0 || parse_number(args[2], LONG_MAX, &every) != 0) {
+            return badcommandCheckpoint();
+        }
+    }
+    if (scheduler_checkpoint(args[0], every) != 0) {
+        return badcommandCheckpoint();
+    }
+    return 0;
+}
+
+int restore(char *path) {
+    int rc = scheduler_restore(path);
+    return rc < 0 ? badcommandRestore() : rc;
+}
+
+int ps() {
+    // Lock-free snapshot (see procinfo.h): safe while MT workers or a
+    // background exec are running, and never holds them up.
+    static const char *state_names[] = {
+        [PS_READY] = "READY", [PS_RUNNING] = "RUNNING", [PS_WAITING] = "WAITING",
+    };
+    static ProcInfo procs[MEM_SIZE];
+    int n = procinfo_snapshot(procs, MEM_SIZE);
+
+    printf("PID PPID STATE WORKER PC LEFT SCORE\n");
+    for (int i = 0; i < n; i++) {
+        ProcInfo *p = &procs[i];
+        char worker[16];
+        if (p->state != PS_RUNNING) {
+            snprintf(worker, sizeof(worker), "-");
+        } else if (p->worker < 0) {
+            snprintf(worker, sizeof(worker), "main");
+        } else {
+            snprintf(worker, sizeof(worker), "%d", p->worker);
+        }
+        printf("%d %d %s %s %d %d %d\n", p->pid, p->ppid,
+               state_names[p->state], worker, p->pc - p->start,
+               p->end - p->pc + 1, p->score);
+    }
+    return 0;
+}
+
+int compile(char *script) {
+    // Writes SCRIPT.mshc, which exec/source then load instead of the text
+    // for as long as SCRIPT is unchanged (see progimage.h).
+    if (progimage_compile(script) != 0) {
+        return badcommandCompile();
+    }
+    return 0;
+}
+
+int stats() {
+    InternStats is;
+    intern_get_stats(&is);
+    printf("interned %ld strings, %ld bytes for %ld references (%ld bytes as copies)\n",
+           is.strings, is.bytes, is.refs, is.copy_bytes);
+    hotstats_print(stdout);
+    return 0;
+}
@@ -0,0 +1,82 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "linereader.h"
+
+#define LINEREADER_INITIAL_CAP (1 << 20)
+
+int linereader_init(LineReader *r, int fd) {
+    r->fd = fd;
+    r->cap = LINEREADER_INITIAL_CAP;
+    r->buf = malloc(r->cap);
+    r->start = r->end = 0;
+    r->eof = 0;
+    return r->buf == NULL ? -1 : 0;
+}
+
+void linereader_free(LineReader *r) {
+    free(r->buf);
+    r->buf = NULL;
+}
+
+// Make room after r->end: slide the unconsumed bytes to the front, and only
+// grow the buffer when a single line already fills all of it. One byte is
+// always kept spare for the terminator of an unterminated last line.
+static int linereader_fill(LineReader *r) {
+    ssize_t n;
+
+    if (r->start > 0) {
+        memmove(r->buf, r->buf + r->start, r->end - r->start);
+        r->end -= r->start;
+        r->start = 0;
+    }
+    if (r->end + 1 >= r->cap) {
+        char *grown = realloc(r->buf, r->cap * 2);
+        if (grown == NULL) {
+            return -1;
+        }
+        r->buf = grown;
+        r->cap *= 2;
+    }
+
+    do {
+        n = read(r->fd, r->buf + r->end, r->cap - 1 - r->end);
+    } while (n < 0 && errno == EINTR);
+
+    if (n <= 0) {
+        r->eof = 1;
+        return -1;
+    }
+    r->end += n;
+    return 0;
+}
+
+char *linereader_next(LineReader *r) {
+    size_t scanned = 0;     // bytes of the current line already searched
+
+    while (1) {
+        char *line = r->buf + r->start;
+        // memchr is the libc's vectorized search, so long runs of text
+        // cost a few bytes per cycle rather than one.
+        char *nl = memchr(line + scanned, '\n', r->end - r->start - scanned);
+        if (nl != NULL) {
+            *nl = '\0';
+            r->start = nl + 1 - r->buf;
+            return line;
+        }
+        scanned = r->end - r->start;
+
+        if (r->eof || linereader_fill(r) != 0) {
+            if (r->end == r->start) {
+                return NULL;
+            }
+            // Last line without a trailing newline
+            line = r->buf + r->start;
+            r->buf[r->end] = '\0';
+            r->start = r->end;
+            return line;
+        }
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef LINEREADER_H
+#define LINEREADER_H
+
+#include <stddef.h>
+
+// Streaming line reader for batch input (see shell.c main). Lines are
+// handed out in place, with their newline replaced by '\0', and stay valid
+// until the next call. Lines of any length are supported.
+typedef struct {
+    int fd;
+    char *buf;
+    size_t cap;
+    size_t start;   // first unconsumed byte
+    size_t end;     // one past the last byte read
+    int eof;
+} LineReader;
+
+int linereader_init(LineReader *r, int fd);
+char *linereader_next(LineReader *r);   // NULL once input is exhausted
+void linereader_free(LineReader *r);
+
+#endif
@@ -0,0 +1,233 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+
+#include "lscache.h"
+
+#define WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO \
+                    | IN_DELETE_SELF | IN_MOVE_SELF)
+
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+    int wd;                 // inotify watch, -1 if none
+    int valid;              // text is the current listing
+    char *text;             // names, one per line
+    size_t len;
+    unsigned long used;     // last listed, for eviction; 0 if the slot is free
+} LsDir;
+
+static pthread_mutex_t ls_mutex = PTHREAD_MUTEX_INITIALIZER;
+static LsDir dirs[LSCACHE_DIRS];
+static unsigned long ls_clock = 0;
+static int inotify_fd = -2;     // -2 not opened yet, -1 unavailable
+
+/*
+ * my_ls order, one character at a time: by lowercase form, so digits come
+ * before letters and A and a sort together; then a capital letter before
+ * its small one (A a B b ...); a name before any longer name it starts.
+ * That is a total order on bytes, so each byte gets a rank 1..255 and a
+ * name's sort key is its bytes replaced by their ranks: strcmp on the keys
+ * is the my_ls order, with no per-character case folding in the sort.
+ */
+static unsigned char rank[256];
+static pthread_once_t rank_once = PTHREAD_ONCE_INIT;
+
+static int byte_compare(const void *pa, const void *pb) {
+    int a = *(const unsigned char *)pa, b = *(const unsigned char *)pb;
+    // As signed chars, like the names were compared before keys were used.
+    int lower_a = (signed char)tolower(a), lower_b = (signed char)tolower(b);
+    if (lower_a != lower_b) {
+        return lower_a - lower_b;
+    }
+    return (signed char)a - (signed char)b;
+}
+
+static void rank_init(void) {
+    unsigned char bytes[255];
+    for (int i = 0; i < 255; i++) {
+        bytes[i] = i + 1;
+    }
+    qsort(bytes, 255, 1, byte_compare);
+    for (int i = 0; i < 255; i++) {
+        rank[bytes[i]] = i + 1;
+    }
+}
+
+typedef struct {
+    const char *key;
+    const char *name;
+} LsEntry;
+
+static int entry_compare(const void *a, const void *b) {
+    return strcmp(((const LsEntry *)a)->key, ((const LsEntry *)b)->key);
+}
+
+// Scans the current directory into a sorted listing in d->text.
+static int scan(LsDir *d) {
+    DIR *dir = opendir(".");
+    if (dir == NULL) {
+        return -1;
+    }
+    // Names and then their keys go in one arena, entries point into it
+    // once it stops moving.
+    size_t cap = 4096, used = 0, n = 0, ncap = 256;
+    char *arena = malloc(cap);
+    size_t *offs = malloc(ncap * sizeof(size_t));
+    LsEntry *entries = NULL;
+    char *text = NULL;
+    struct dirent *e;
+    int rc = -1, complete = 0;
+
+    errno = 0;
+    while (arena != NULL && offs != NULL) {
+        if ((e = readdir(dir)) == NULL) {
+            complete = errno == 0;
+            break;
+        }
+        size_t len = strlen(e->d_name) + 1;
+        if (used + 2 * len > cap) {
+            while (used + 2 * len > cap) cap *= 2;
+            char *grown = realloc(arena, cap);
+            if (grown == NULL) break;
+            arena = grown;
+        }
+        if (n == ncap) {
+            size_t *grown = realloc(offs, 2 * ncap * sizeof(size_t));
+            if (grown == NULL) break;
+            offs = grown;
+            ncap *= 2;
+        }
+        offs[n++] = used;
+        memcpy(arena + used, e->d_name, len);
+        char *key = arena + used + len;
+        for (size_t i = 0; i < len; i++) {
+            key[i] = rank[(unsigned char)e->d_name[i]];
+        }
+        used += 2 * len;
+    }
+    int scan_errno = errno;
+    closedir(dir);
+
+    if (complete && (entries = malloc((n > 0 ? n : 1) * sizeof(LsEntry))) != NULL) {
+        size_t text_len = 0;
+        for (size_t i = 0; i < n; i++) {
+            entries[i].name = arena + offs[i];
+            size_t len = strlen(entries[i].name);
+            entries[i].key = entries[i].name + len + 1;
+            text_len += len + 1;
+        }
+        qsort(entries, n, sizeof(LsEntry), entry_compare);
+        if ((text = malloc(text_len > 0 ? text_len : 1)) != NULL) {
+            char *p = text;
+            for (size_t i = 0; i < n; i++) {
+                size_t len = strlen(entries[i].name);
+                memcpy(p, entries[i].name, len);
+                p[len] = '\n';
+                p += len + 1;
+            }
+            free(d->text);
+            d->text = text;
+            d->len = text_len;
+            rc = 0;
+        }
+    }
+    free(entries);
+    free(offs);
+    free(arena);
+    if (rc != 0) {
+        errno = scan_errno != 0 ? scan_errno : ENOMEM;
+    }
+    return rc;
+}
+
+// Applies the pending inotify events: any change drops that listing.
+static void drain_events(void) {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+
+    while ((len = read(inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len; ) {
+            struct inotify_event *ev = (struct inotify_event *)p;
+            for (int i = 0; i < LSCACHE_DIRS; i++) {
+                if (ev->mask & IN_Q_OVERFLOW) {
+                    dirs[i].valid = 0;
+                } else if (dirs[i].wd == ev->wd) {
+                    dirs[i].valid = 0;
+                    if (ev->mask & IN_IGNORED) {
+                        dirs[i].wd = -1;    // gone, its watch with it
+                    }
+                }
+            }
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+}
+
+// The slot for the directory, reusing the least recently listed one.
+static LsDir *lookup(const struct stat *st) {
+    LsDir *victim = &dirs[0];
+    for (int i = 0; i < LSCACHE_DIRS; i++) {
+        if (dirs[i].used != 0 && dirs[i].dev == st->st_dev
+            && dirs[i].ino == st->st_ino) {
+            return &dirs[i];
+        }
+        if (dirs[i].used < victim->used) {
+            victim = &dirs[i];
+        }
+    }
+    if (victim->wd >= 0) {
+        inotify_rm_watch(inotify_fd, victim->wd);
+    }
+    free(victim->text);
+    memset(victim, 0, sizeof(*victim));
+    victim->wd = -1;
+    victim->dev = st->st_dev;
+    victim->ino = st->st_ino;
+    return victim;
+}
+
+int lscache_list(FILE *out) {
+    struct stat st;
+    int rc = 0;
+
+    pthread_once(&rank_once, rank_init);
+    pthread_mutex_lock(&ls_mutex);
+    if (inotify_fd == -2) {
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        for (int i = 0; i < LSCACHE_DIRS; i++) {
+            dirs[i].wd = -1;
+        }
+    }
+    if (stat(".", &st) != 0) {
+        pthread_mutex_unlock(&ls_mutex);
+        return -1;
+    }
+    if (inotify_fd >= 0) {
+        drain_events();
+    }
+
+    LsDir *d = lookup(&st);
+    d->used = ++ls_clock;
+    if (!d->valid) {
+        // Watch first, so a change made while scanning drops the listing.
+        if (d->wd < 0 && inotify_fd >= 0) {
+            d->wd = inotify_add_watch(inotify_fd, ".", WATCH_MASK);
+        }
+        rc = scan(d);
+        d->valid = rc == 0 && d->wd >= 0;
+    }
+    if (rc == 0) {
+        fwrite(d->text, 1, d->len, out);
+    }
+    int saved_errno = errno;
+    pthread_mutex_unlock(&ls_mutex);
+    errno = saved_errno;
+    return rc;
+}
@@ -0,0 +1,19 @@
+#ifndef LSCACHE_H
+#define LSCACHE_H
+
+#include <stdio.h>
+
+// my_ls listings. The listing of a directory is sorted and formatted once
+// and kept until inotify reports a change to the directory, so scripts
+// that list the same directory in a loop pay for one scan. Each name's
+// sort key is computed once (see lscache.c) and the keys compare with
+// strcmp. A few directories are kept, least recently listed dropped first.
+// Without inotify every call lists afresh. Safe to call from any thread.
+
+#define LSCACHE_DIRS 4
+
+// Writes the listing of the current directory, one name per line, to out
+// in one write. 0 on success, -1 with errno set if it cannot be read.
+int lscache_list(FILE *out);
+
+#endif
@@ -1,6 +1,10 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <limits.h>
 #include "pcb.h"
+#include "shellmemory.h"
+#include "procinfo.h"
+#include "scriptload.h"
 
 int pid_counter = 0; // global pid counter
 
@@ -11,12 +15,43 @@ PCB* make_pcb(int start, int end) {
         fprintf(stderr, "Memory allocation failed for PCB\n");
         return NULL;
     }
-    new_pcb->pid = ++pid_counter; //pre increment to start from 1
+    // atomic: nested exec/source also create PCBs on the MT workers
+    new_pcb->pid = __atomic_add_fetch(&pid_counter, 1, __ATOMIC_RELAXED); // starts from 1
     new_pcb->start = start;
     new_pcb->end = end;
     new_pcb->pc = start; // 1.2.1 program counter
     new_pcb->job_time = (end - start+1); // 1.2.3 SJF uses line count as job length
     new_pcb->job_length_score = new_pcb->job_time; // (NOT in the video) 1.2.4 AGING score starts = job length
+    new_pcb->loop_depth = 0;
+    new_pcb->vars = NULL;
+    new_pcb->parent_pid = 0;
+    new_pcb->parent = NULL;
+    new_pcb->children_alive = 0;
+    new_pcb->waiting = 0;
+    new_pcb->parked = 0;
+    new_pcb->finished = 0;
+    new_pcb->quota = quota_defaults;
+    new_pcb->used = (QuotaUsage){0, 0, 0, 0};
+    new_pcb->quota_hit = QUOTA_OK;
+    new_pcb->ps_slot = procinfo_slot_alloc();
+    new_pcb->map = NULL;
+    new_pcb->last_worker = -1;
+    new_pcb->group = NULL;
+    new_pcb->deadline = LONG_MAX;
+    new_pcb->deadline_own = 0;
+    new_pcb->deadline_seq = 0;
     new_pcb->next = NULL; // Initialize next pointer to NULL
     return new_pcb;
 }
+
+// Releases the PCB and its private variables (not its code, see
+// mem_cleanup_script)
+void pcb_free(PCB *pcb) {
+    if (pcb == NULL) {
+        return;
+    }
+    procinfo_slot_free(pcb->ps_slot);
+    script_map_free(pcb->map);
+    mem_scope_free(pcb->vars);
+    free(pcb);
+}
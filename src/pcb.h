@@ -1,6 +1,14 @@
 #ifndef PCB_H
 #define PCB_H
 
+#include "quota.h"
+
+struct VarScope;
+struct ScriptMap;
+struct ShareGroup;
+
+#define PCB_LOOP_DEPTH 8 // deepest repeat nesting a script may use
+
 typedef struct PCB {
     int pid;
     int start;
@@ -8,9 +16,30 @@ typedef struct PCB {
     int pc; // 1.2.1 Program Counter
     int job_time; // 1.2.3 estimated length (line count)
     int job_length_score; // 1.2.4 AGING score
+    int loop_depth; // active repeat loops
+    int loop_remaining[PCB_LOOP_DEPTH]; // iterations left, innermost last
+    struct VarScope *vars; // private variables (exec ... ISOLATE), else NULL
+    // Nested source/exec (see scheduler_spawn). Guarded by the scheduler.
+    int parent_pid; // 0 for programs started from the shell prompt
+    struct PCB *parent; // stays valid until this PCB finishes
+    int children_alive; // spawned children that have not finished
+    int waiting; // in source/wait until children_alive drops to 0
+    int parked; // off the ready queue while waiting
+    int finished; // done, kept only until its last child finishes
+    Quota quota; // limits, copied from quota_defaults at creation
+    QuotaUsage used; // charged per slice and per set
+    int quota_hit; // QuotaKind waiting for quota_enforce, else QUOTA_OK
+    int ps_slot; // procinfo table slot, -1 if the table was full
+    struct ScriptMap *map; // script text lines are loaded from, else NULL
+    int last_worker; // MT worker that last ran it, -1 if none
+    struct ShareGroup *group; // exec batch it shares the MT workers with
+    long deadline; // EDF: absolute, in engine instructions; LONG_MAX if none
+    int deadline_own; // set by exec ... DEADLINE, counted by edfstats
+    unsigned long deadline_seq; // EDF heap order among equal deadlines
     struct PCB *next; // Pointer to the next PCB in the queue
 } PCB;
 
 PCB* make_pcb(int start, int end);
+void pcb_free(PCB *pcb);
 
 #endif
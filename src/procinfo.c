@@ -0,0 +1,100 @@
+#include <stdlib.h>
+
+#include "procinfo.h"
+#include "shellmemory.h"
+
+// A program holds at least one code line, so MEM_SIZE PCBs can be alive.
+#define PROCINFO_SLOTS MEM_SIZE
+
+typedef struct {
+    unsigned seq;       // odd while the owner is writing
+    int in_use;         // allocation flag, outside the seqlock
+    ProcInfo info;      // info.pid == 0 while the slot is empty
+} __attribute__((aligned(64))) ProcSlot;
+
+static ProcSlot slots[PROCINFO_SLOTS];
+static int slots_high = 0;      // slots at or past this were never used
+
+int procinfo_slot_alloc(void) {
+    for (int i = 0; i < PROCINFO_SLOTS; i++) {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&slots[i].in_use, &expected, 1, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            int high = __atomic_load_n(&slots_high, __ATOMIC_RELAXED);
+            while (high < i + 1
+                   && !__atomic_compare_exchange_n(&slots_high, &high, i + 1, 0,
+                                                   __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+            return i;
+        }
+    }
+    return -1;
+}
+
+// The field stores are releases and the reader's field loads acquires, so
+// a reader that sees any new field also sees the odd seq before it, and
+// its second seq load cannot move above the fields. No fences: TSan models
+// these orderings, but not __atomic_thread_fence.
+static void slot_write(ProcSlot *s, const ProcInfo *info) {
+    unsigned seq = __atomic_load_n(&s->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&s->seq, seq + 1, __ATOMIC_RELAXED);
+    int *dst = (int *)&s->info;
+    const int *src = (const int *)info;
+    for (size_t k = 0; k < sizeof(ProcInfo) / sizeof(int); k++) {
+        __atomic_store_n(&dst[k], src[k], __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&s->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+void procinfo_slot_free(int slot) {
+    ProcInfo empty = {0};
+    if (slot < 0) return;
+    slot_write(&slots[slot], &empty);
+    __atomic_store_n(&slots[slot].in_use, 0, __ATOMIC_RELEASE);
+}
+
+void procinfo_publish(const PCB *pcb, ProcState state, int worker) {
+    ProcInfo info;
+    if (pcb->ps_slot < 0) return;
+    info.pid = pcb->pid;
+    info.ppid = pcb->parent_pid;
+    info.state = state;
+    info.worker = worker;
+    info.pc = pcb->pc;
+    info.start = pcb->start;
+    info.end = pcb->end;
+    info.score = pcb->job_length_score;
+    slot_write(&slots[pcb->ps_slot], &info);
+}
+
+static int info_cmp(const void *a, const void *b) {
+    return ((const ProcInfo *)a)->pid - ((const ProcInfo *)b)->pid;
+}
+
+int procinfo_snapshot(ProcInfo *out, int max) {
+    int n = 0;
+    int high = __atomic_load_n(&slots_high, __ATOMIC_ACQUIRE);
+
+    for (int i = 0; i < high && n < max; i++) {
+        ProcSlot *s = &slots[i];
+        ProcInfo copy;
+        unsigned before, after;
+        do {
+            before = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+            if (before & 1) {
+                after = before + 1;     // mid-write, try again
+                continue;
+            }
+            int *dst = (int *)&copy;
+            const int *src = (const int *)&s->info;
+            for (size_t k = 0; k < sizeof(ProcInfo) / sizeof(int); k++) {
+                dst[k] = __atomic_load_n(&src[k], __ATOMIC_ACQUIRE);
+            }
+            after = __atomic_load_n(&s->seq, __ATOMIC_RELAXED);
+        } while (before != after);
+        if (copy.pid != 0) {
+            out[n++] = copy;
+        }
+    }
+    qsort(out, n, sizeof(ProcInfo), info_cmp);
+    return n;
+}
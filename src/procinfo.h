@@ -0,0 +1,35 @@
+#ifndef PROCINFO_H
+#define PROCINFO_H
+
+#include "pcb.h"
+
+// Process table for ps and other monitoring. Every live PCB owns one slot,
+// which whoever currently owns the PCB (the thread running it, or the
+// ready queue lock holder) republishes at each state change. Slots are
+// seqlocks: readers copy optimistically and retry on a concurrent write, so
+// a snapshot never takes a lock and never delays dispatch.
+typedef enum {
+    PS_READY = 0,
+    PS_RUNNING,
+    PS_WAITING      // in source/wait until its children finish
+} ProcState;
+
+typedef struct {
+    int pid;
+    int ppid;
+    ProcState state;
+    int worker;     // MT worker running it, -1 for the shell thread
+    int pc;
+    int start;
+    int end;
+    int score;      // SJF job length / AGING score
+} ProcInfo;
+
+int procinfo_slot_alloc(void);          // -1 if the table is full
+void procinfo_slot_free(int slot);
+void procinfo_publish(const PCB *pcb, ProcState state, int worker);
+
+// Copies up to max live processes into out, ordered by PID; returns the count.
+int procinfo_snapshot(ProcInfo *out, int max);
+
+#endif
@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "progimage.h"
+#include "scriptload.h"
+#include "shellmemory.h"
+#include "control.h"
+
+#define INTERN_SLOTS 2048   // power of two, > 2 * MEM_SIZE
+
+static void image_path(const char *script, char *out, size_t size) {
+    snprintf(out, size, "%s%s", script, PROGIMAGE_SUFFIX);
+}
+
+static uint32_t str_hash(const char *s) {
+    uint32_t h = 2166136261u;   // FNV-1a
+    while (*s) {
+        h = (h ^ (unsigned char)*s++) * 16777619u;
+    }
+    return h;
+}
+
+// Builds the image of the script loaded at [start, end] into a malloc'd
+// buffer. Returns its size, or 0 if out of memory.
+static size_t image_build(int start, int end, int cost, const struct stat *st,
+                          char **out) {
+    int count = end - start + 1;
+    const char *slot_str[INTERN_SLOTS] = { NULL };
+    uint32_t slot_off[INTERN_SLOTS];
+    size_t strtab_size = 0;
+    int strings = 0;
+
+    for (int i = 0; i < count; i++) {
+        strtab_size += strlen(mem_get_code(start + i)->line) + 1;
+    }
+    size_t ops_size = count * sizeof(ProgImageOp);
+    char *buf = malloc(sizeof(ProgImageHeader) + ops_size + strtab_size);
+    if (buf == NULL) {
+        return 0;
+    }
+    ProgImageHeader *h = (ProgImageHeader *)buf;
+    ProgImageOp *ops = (ProgImageOp *)(h + 1);
+    char *strtab = (char *)(ops + count);
+    size_t used = 0;
+
+    for (int i = 0; i < count; i++) {
+        CodeLine *code = mem_get_code(start + i);
+        uint32_t slot = str_hash(code->line) & (INTERN_SLOTS - 1);
+        while (slot_str[slot] != NULL && strcmp(slot_str[slot], code->line) != 0) {
+            slot = (slot + 1) & (INTERN_SLOTS - 1);
+        }
+        if (slot_str[slot] == NULL) {
+            size_t len = strlen(code->line) + 1;
+            memcpy(strtab + used, code->line, len);
+            slot_str[slot] = code->line;
+            slot_off[slot] = used;
+            used += len;
+            strings++;
+        }
+        ops[i].str = slot_off[slot];
+        ops[i].op = code->op;
+        ops[i].arg = code->arg;
+        ops[i].target = code->op == OP_CMD ? -1 : code->target - start;
+    }
+
+    h->magic = PROGIMAGE_MAGIC;
+    h->version = PROGIMAGE_VERSION;
+    h->src_mtime_sec = st->st_mtim.tv_sec;
+    h->src_mtime_nsec = st->st_mtim.tv_nsec;
+    h->src_size = st->st_size;
+    h->count = count;
+    h->cost = cost;
+    h->strings = strings;
+    h->strtab_size = used;
+    *out = buf;
+    return sizeof(ProgImageHeader) + ops_size + used;
+}
+
+// Written next to the script and renamed into place, so a concurrent exec
+// sees either the old image or the new one.
+static int image_write(const char *script, const char *buf, size_t size) {
+    char path[4096], tmp[4200];
+    image_path(script, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid());
+
+    FILE *f = fopen(tmp, "wb");
+    if (f == NULL) {
+        return -1;
+    }
+    int ok = fwrite(buf, 1, size, f) == size;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+int progimage_compile(char *script) {
+    ScriptImage img;
+    struct stat st;
+    char *buf = NULL;
+    int start = 0, end = -1, cost = -1;
+    size_t size = 0;
+
+    if (stat(script, &st) != 0) {
+        return -1;
+    }
+    // Load it the way exec would, text and all, so the image holds exactly
+    // the code memory a text load produces.
+    script_load_begin(&img, &script, 1);
+    if (script_load_wait(&img) == 0) {
+        if (img.count > 0) {
+            start = mem_load_script(img.lines, img.count);
+            end = start + img.count - 1;
+        }
+        if (start >= 0) {
+            img.count = 0;
+            if (img.map != NULL) {
+                script_map_attach(img.map, start);
+                for (int i = start; i <= end; i++) {
+                    if (mem_get_code(i)->line == mem_unloaded_line) {
+                        script_map_fill(img.map, i);
+                    }
+                }
+            }
+            cost = control_compile(start, end);
+            if (cost >= 0) {
+                size = image_build(start, end, cost, &st, &buf);
+            }
+            mem_cleanup_script(start, end);
+        }
+    }
+    script_image_free(&img);
+
+    int rc = (size > 0) ? image_write(script, buf, size) : -1;
+    free(buf);
+    return rc;
+}
+
+// The control lines must be what control_compile would make of the text:
+// each repeat/if linked both ways with the end that closes it, nesting no
+// deeper than a text load allows. Code memory runs them as they are.
+static int image_links_valid(const ProgImageHeader *h) {
+    const ProgImageOp *ops = progimage_ops(h);
+    const char *strtab = progimage_strtab(h);
+    int open_at[CONTROL_MAX_NESTING];
+    int depth = 0, loops = 0;
+
+    for (int i = 0; i < h->count; i++) {
+        if (ops[i].op == OP_CMD) {
+            continue;
+        }
+        int arg = 0;
+        if (control_classify_line(strtab + ops[i].str, &arg) != ops[i].op) {
+            return 0;
+        }
+        if (ops[i].op == OP_END) {
+            if (depth == 0 || ops[i].target != open_at[depth - 1]
+                || ops[ops[i].target].target != i) {
+                return 0;
+            }
+            loops -= ops[open_at[--depth]].op == OP_REPEAT;
+            continue;
+        }
+        // An empty loop is compiled to a count of 0.
+        if (depth == CONTROL_MAX_NESTING || ops[i].target <= i
+            || (ops[i].op == OP_REPEAT
+                && ((ops[i].arg != arg && ops[i].arg != 0) || ++loops > PCB_LOOP_DEPTH))) {
+            return 0;
+        }
+        open_at[depth++] = i;
+    }
+    return depth == 0;
+}
+
+static int image_valid(const ProgImageHeader *h, size_t size) {
+    if (size < sizeof(ProgImageHeader) || h->magic != PROGIMAGE_MAGIC
+        || h->version != PROGIMAGE_VERSION || h->count < 0
+        || h->count > MEM_SIZE || h->cost < 0) {
+        return 0;
+    }
+    size_t need = sizeof(ProgImageHeader) + h->count * sizeof(ProgImageOp);
+    if (size < need || size - need != h->strtab_size) {
+        return 0;
+    }
+    const ProgImageOp *ops = progimage_ops(h);
+    const char *strtab = progimage_strtab(h);
+    if (h->strtab_size > 0 && strtab[h->strtab_size - 1] != '\0') {
+        return 0;
+    }
+    for (int i = 0; i < h->count; i++) {
+        if (ops[i].str >= h->strtab_size || ops[i].op < OP_CMD || ops[i].op > OP_END
+            || (ops[i].op != OP_CMD && (ops[i].target < 0 || ops[i].target >= h->count))) {
+            return 0;
+        }
+    }
+    return image_links_valid(h);
+}
+
+const ProgImageHeader *progimage_map(const char *script, size_t *size) {
+    struct stat src, st;
+    char path[4096];
+
+    if (stat(script, &src) != 0) {
+        return NULL;
+    }
+    image_path(script, path, sizeof(path));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(ProgImageHeader)) {
+        close(fd);
+        return NULL;
+    }
+    ProgImageHeader *h = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (h == MAP_FAILED) {
+        return NULL;
+    }
+    if (!image_valid(h, st.st_size) || h->src_mtime_sec != src.st_mtim.tv_sec
+        || h->src_mtime_nsec != src.st_mtim.tv_nsec || h->src_size != src.st_size) {
+        munmap(h, st.st_size);
+        return NULL;
+    }
+    *size = st.st_size;
+    return h;
+}
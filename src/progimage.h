@@ -0,0 +1,55 @@
+#ifndef PROGIMAGE_H
+#define PROGIMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Compiled programs (compile builtin, mysh --compile). SCRIPT.mshc holds
+ * what loading SCRIPT would produce: one record per code line with its
+ * repeat/if/end links already resolved, the line texts interned into a
+ * string table, and the job length. exec/source map a fresh image and
+ * point code memory straight into it instead of reading and classifying
+ * the text. An image is fresh while SCRIPT's mtime and size match the
+ * ones it recorded; a stale one is ignored.
+ *
+ *   ProgImageHeader | ProgImageOp[count] | string table (NUL-terminated)
+ */
+#define PROGIMAGE_MAGIC 0x4348534d     // "MSHC"
+#define PROGIMAGE_VERSION 1
+#define PROGIMAGE_SUFFIX ".mshc"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    int64_t src_mtime_sec;
+    int64_t src_mtime_nsec;
+    int64_t src_size;
+    int32_t count;          // code lines
+    int32_t cost;           // job length, as control_compile computes it
+    int32_t strings;        // distinct line texts
+    uint32_t strtab_size;   // bytes
+} ProgImageHeader;
+
+typedef struct {
+    uint32_t str;           // string table offset of the line text
+    int32_t op;             // CodeOp
+    int32_t arg;
+    int32_t target;         // line index relative to the script, or -1
+} ProgImageOp;
+
+// Writes SCRIPT.mshc. 0 on success, -1 if the script does not load.
+int progimage_compile(char *script);
+
+// Maps SCRIPT.mshc if it is fresh and well-formed, else returns NULL.
+const ProgImageHeader *progimage_map(const char *script, size_t *size);
+
+static inline const ProgImageOp *progimage_ops(const ProgImageHeader *h) {
+    return (const ProgImageOp *)(h + 1);
+}
+
+static inline const char *progimage_strtab(const ProgImageHeader *h) {
+    return (const char *)(progimage_ops(h) + h->count);
+}
+
+#endif
@@ -0,0 +1,118 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+
+#include "quota.h"
+#include "pcb.h"
+#include "shellmemory.h"
+
+Quota quota_defaults = {0, 0, 0, 0, QUOTA_LOG};
+
+static const char *action_names[] = {
+    [QUOTA_LOG] = "log",
+    [QUOTA_KILL] = "kill",
+    [QUOTA_DEMOTE] = "demote",
+};
+
+static const char *kind_names[] = {
+    [QUOTA_INSTRUCTIONS] = "instructions",
+    [QUOTA_VARS] = "vars",
+    [QUOTA_BYTES] = "bytes",
+    [QUOTA_TIME] = "time",
+};
+
+int quota_configure(const char *kind, const char *value) {
+    if (strcmp(kind, "action") == 0) {
+        for (int a = QUOTA_LOG; a <= QUOTA_DEMOTE; a++) {
+            if (strcmp(value, action_names[a]) == 0) {
+                quota_defaults.action = a;
+                return 0;
+            }
+        }
+        return 1;
+    }
+
+    char *end;
+    long n = strtol(value, &end, 10);
+    if (*value == '\0' || *end != '\0' || n < 0) {
+        return 1;
+    }
+    if (strcmp(kind, "instructions") == 0) {
+        quota_defaults.max_instructions = n;
+    } else if (strcmp(kind, "vars") == 0) {
+        quota_defaults.max_vars = n;
+    } else if (strcmp(kind, "bytes") == 0) {
+        quota_defaults.max_bytes = n;
+    } else if (strcmp(kind, "time") == 0) {
+        quota_defaults.max_ms = n;
+    } else {
+        return 1;
+    }
+    return 0;
+}
+
+void quota_print(void) {
+    printf("instructions %ld\n", quota_defaults.max_instructions);
+    printf("vars %ld\n", quota_defaults.max_vars);
+    printf("bytes %ld\n", quota_defaults.max_bytes);
+    printf("time %ld\n", quota_defaults.max_ms);
+    printf("action %s\n", action_names[quota_defaults.action]);
+}
+
+void quota_check_slice(PCB *pcb) {
+    if (pcb->quota.max_instructions > 0
+        && pcb->used.instructions >= pcb->quota.max_instructions) {
+        pcb->quota_hit = QUOTA_INSTRUCTIONS;
+    } else if (pcb->quota.max_ms > 0
+               && pcb->used.ns >= pcb->quota.max_ms * 1000000L) {
+        pcb->quota_hit = QUOTA_TIME;
+    }
+}
+
+int quota_charge_set(PCB *pcb, const char *var, const char *value) {
+    long len = (long)strlen(value);
+
+    if (pcb->quota.max_bytes > 0 && pcb->used.bytes + len > pcb->quota.max_bytes) {
+        pcb->quota_hit = QUOTA_BYTES;
+    } else if (pcb->quota.max_vars > 0 && pcb->used.vars >= pcb->quota.max_vars) {
+        // Only a new variable counts; overwriting one is always allowed.
+        if (!mem_var_is_set((char *)var)) {
+            pcb->quota_hit = QUOTA_VARS;
+        }
+    }
+    if (pcb->quota_hit != QUOTA_OK && pcb->quota.action != QUOTA_LOG) {
+        return 1;
+    }
+    pcb->used.bytes += len;
+    return 0;
+}
+
+int quota_enforce(PCB *pcb) {
+    QuotaKind kind = pcb->quota_hit;
+    long *limit = NULL;
+
+    switch (kind) {
+    case QUOTA_INSTRUCTIONS: limit = &pcb->quota.max_instructions; break;
+    case QUOTA_VARS: limit = &pcb->quota.max_vars; break;
+    case QUOTA_BYTES: limit = &pcb->quota.max_bytes; break;
+    case QUOTA_TIME: limit = &pcb->quota.max_ms; break;
+    default: return 0;
+    }
+    printf("Quota exceeded: pid %d %s %ld (%s)\n", pcb->pid, kind_names[kind],
+           *limit, action_names[pcb->quota.action]);
+    pcb->quota_hit = QUOTA_OK;
+
+    if (pcb->quota.action == QUOTA_KILL) {
+        pcb->pc = pcb->end + 1;
+        return 0;
+    }
+    // log and demote report once: the limit is lifted and the program goes on
+    *limit = 0;
+    if (pcb->quota.action == QUOTA_DEMOTE) {
+        pcb->job_time = INT_MAX;
+        pcb->job_length_score = INT_MAX;
+        return 1;
+    }
+    return 0;
+}
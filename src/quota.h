@@ -0,0 +1,51 @@
+#ifndef QUOTA_H
+#define QUOTA_H
+
+// Per-program resource quotas (the quota command). Limits are copied into
+// each PCB when it is created; 0 means unlimited. The counters live in the
+// PCB and are charged once per slice (instructions, time) or per set
+// (variables, bytes), so a program without limits pays one add and compare.
+typedef enum {
+    QUOTA_LOG = 0,      // report once, keep running
+    QUOTA_KILL,         // stop the program
+    QUOTA_DEMOTE        // report once, run it after everything else
+} QuotaAction;
+
+typedef enum {
+    QUOTA_OK = 0,
+    QUOTA_INSTRUCTIONS,
+    QUOTA_VARS,
+    QUOTA_BYTES,
+    QUOTA_TIME
+} QuotaKind;
+
+typedef struct {
+    long max_instructions;  // commands and repeat back-jumps executed
+    long max_vars;          // new variables created
+    long max_bytes;         // bytes of values set
+    long max_ms;            // time spent running, in milliseconds
+    QuotaAction action;
+} Quota;
+
+typedef struct {
+    long instructions;
+    long vars;
+    long bytes;
+    long ns;
+} QuotaUsage;
+
+struct PCB;
+
+extern Quota quota_defaults;    // limits for programs loaded from now on
+
+int quota_configure(const char *kind, const char *value);  // 0 on success
+void quota_print(void);
+
+// Instruction/time check after a slice; sets pcb->quota_hit.
+void quota_check_slice(struct PCB *pcb);
+// set VAR VALUE from a program: 0 if the set may proceed.
+int quota_charge_set(struct PCB *pcb, const char *var, const char *value);
+// Apply pcb->quota_hit. Returns 1 if the program was demoted.
+int quota_enforce(struct PCB *pcb);
+
+#endif
@@ -1,20 +1,43 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include "ready_queue.h"
+#include "hotstats.h"
+#include "procinfo.h"
 
 // Global pointers to head and tail 
 PCB *head = NULL;
 PCB *tail = NULL;
+static int queue_len = 0;
+
+// EDF: binary min-heap on (deadline, deadline_seq), next to the list. Its
+// entries count in queue_len too.
+static PCB **heap = NULL;
+static int heap_len = 0;
+static int heap_cap = 0;
+static unsigned long heap_seq = 0;  // FIFO among equal deadlines
 
 // Add a mutex for thread-safe operations (NOT in the video)
 static pthread_mutex_t rq_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+// Every operation runs entirely under rq_mutex, so timing lock to unlock
+// covers each ready_queue_* call, lock wait included (see hotstats.h).
+#ifdef MYSH_STATS
+static __thread uint64_t rq_t0;
+#define RQ_LOCK() do { rq_t0 = hotstats_now(); pthread_mutex_lock(&rq_mutex); } while (0)
+#define RQ_UNLOCK() do { pthread_mutex_unlock(&rq_mutex); HOTSTAT_STOP(HS_QUEUE_OP, rq_t0); } while (0)
+#else
+#define RQ_LOCK() pthread_mutex_lock(&rq_mutex)
+#define RQ_UNLOCK() pthread_mutex_unlock(&rq_mutex)
+#endif
+
 // 1.2.1/1.2.2 FCFS path uses tail enqueue
 void ready_queue_add_to_tail(PCB *p) {
-    pthread_mutex_lock(&rq_mutex);
+    RQ_LOCK();
     
     if (!p) {
-        pthread_mutex_unlock(&rq_mutex);
+        RQ_UNLOCK();
         return;
     }
     p->next = NULL;
@@ -26,16 +49,17 @@ void ready_queue_add_to_tail(PCB *p) {
         tail->next = p;
         tail = p;
     }
+    queue_len++;
     
-    pthread_mutex_unlock(&rq_mutex);
+    RQ_UNLOCK();
 }
 
 // 1.2.4 AGING can keep current process running by putting it back at head
 void ready_queue_add_to_head(PCB *p) {
-    pthread_mutex_lock(&rq_mutex);
+    RQ_LOCK();
     
     if (!p) {
-        pthread_mutex_unlock(&rq_mutex);
+        RQ_UNLOCK();
         return;
     }
 
@@ -47,16 +71,17 @@ void ready_queue_add_to_head(PCB *p) {
         p->next = head;
         head = p;
     }
+    queue_len++;
     
-    pthread_mutex_unlock(&rq_mutex);
+    RQ_UNLOCK();
 }
 
 // shared dequeue for FCFS/RR/AGING
 PCB* ready_queue_pop_head() {
-    pthread_mutex_lock(&rq_mutex);
+    RQ_LOCK();
     
     if (head == NULL) {  // Empty queue
-        pthread_mutex_unlock(&rq_mutex);
+        RQ_UNLOCK();
         return NULL;
     }
 
@@ -69,25 +94,28 @@ PCB* ready_queue_pop_head() {
     }
     
     temp->next = NULL; // Isolate the popped PCB
+    queue_len--;
     
-    pthread_mutex_unlock(&rq_mutex);
+    RQ_UNLOCK();
     return temp;
 }
 
 void ready_queue_insert_sorted(PCB *p) {
-    pthread_mutex_lock(&rq_mutex);
+    RQ_LOCK();
     
     // 1.2.4: keep AGING queue ordered by score (low score first)
     if (!p) {
-        pthread_mutex_unlock(&rq_mutex);
+        RQ_UNLOCK();
         return;
     }
     p->next = NULL;
 
+    queue_len++;
+
     if (head == NULL) {  // Empty queue
         head = p;
         tail = p;
-        pthread_mutex_unlock(&rq_mutex);
+        RQ_UNLOCK();
         return;
     }
 
@@ -95,7 +123,7 @@ void ready_queue_insert_sorted(PCB *p) {
     if (p->job_length_score < head->job_length_score) {
         p->next = head;
         head = p;
-        pthread_mutex_unlock(&rq_mutex);
+        RQ_UNLOCK();
         return;
     }
 
@@ -112,38 +140,39 @@ void ready_queue_insert_sorted(PCB *p) {
         tail = p;
     }
     
-    pthread_mutex_unlock(&rq_mutex);
+    RQ_UNLOCK();
 }
 
 void ready_queue_age_all(void) {
-    pthread_mutex_lock(&rq_mutex);
+    RQ_LOCK();
     
     // 1.2.4 aging step: waiting jobs only, score-- floor at 0
     PCB *curr = head;
     while (curr != NULL) {
         if (curr->job_length_score > 0) {
             curr->job_length_score--;
+            procinfo_publish(curr, PS_READY, -1);
         }
         curr = curr->next;
     }
     
-    pthread_mutex_unlock(&rq_mutex);
+    RQ_UNLOCK();
 }
 
 // Peek at head of queue without removing (for AGING decision)
 PCB* ready_queue_peek_head(void) {
-    pthread_mutex_lock(&rq_mutex);
+    RQ_LOCK();
     PCB *result = head;
-    pthread_mutex_unlock(&rq_mutex);
+    RQ_UNLOCK();
     return result;
 }
 
 // 1.2.3 SJF: pick lowest job_time
 PCB* ready_queue_pop_shortest() {
-    pthread_mutex_lock(&rq_mutex);
+    RQ_LOCK();
     
     if (head == NULL) {
-        pthread_mutex_unlock(&rq_mutex);
+        RQ_UNLOCK();
         return NULL;
     }
 
@@ -175,17 +204,29 @@ PCB* ready_queue_pop_shortest() {
     }
 
     min_node->next = NULL;
+    queue_len--;
     
-    pthread_mutex_unlock(&rq_mutex);
+    RQ_UNLOCK();
     return min_node;
 }
 
+// MT replay: is this PID waiting in the queue?
+int ready_queue_contains_pid(int pid) {
+    RQ_LOCK();
+    PCB *curr = head;
+    while (curr != NULL && curr->pid != pid) {
+        curr = curr->next;
+    }
+    RQ_UNLOCK();
+    return curr != NULL;
+}
+
 // Remove PCB with specific PID
 PCB* ready_queue_pop_pid(int pid) {
-    pthread_mutex_lock(&rq_mutex);
+    RQ_LOCK();
     
     if (head == NULL) {
-        pthread_mutex_unlock(&rq_mutex);
+        RQ_UNLOCK();
         return NULL;
     }
 
@@ -197,7 +238,7 @@ PCB* ready_queue_pop_pid(int pid) {
         curr = curr->next;
     }
     if (curr == NULL) {
-        pthread_mutex_unlock(&rq_mutex);
+        RQ_UNLOCK();
         return NULL;
     }
 
@@ -212,22 +253,205 @@ PCB* ready_queue_pop_pid(int pid) {
     }
 
     curr->next = NULL;
+    queue_len--;
     
-    pthread_mutex_unlock(&rq_mutex);
+    RQ_UNLOCK();
     return curr;
 }
 
+// MT batched dispatch: pop up to max PCBs from the head under one lock.
+// Returns how many were stored in out.
+int ready_queue_pop_batch(PCB **out, int max) {
+    int n = 0;
+
+    RQ_LOCK();
+    while (n < max && head != NULL) {
+        out[n] = head;
+        head = head->next;
+        out[n]->next = NULL;
+        n++;
+    }
+    if (head == NULL) {
+        tail = NULL;
+    }
+    queue_len -= n;
+    RQ_UNLOCK();
+    return n;
+}
+
+// MT batched dispatch: append PCBs to the tail in array order under one lock.
+void ready_queue_add_batch_to_tail(PCB **pcbs, int n) {
+    if (n <= 0) {
+        return;
+    }
+    RQ_LOCK();
+    for (int i = 0; i < n; i++) {
+        pcbs[i]->next = NULL;
+        if (head == NULL) {
+            head = pcbs[i];
+        } else {
+            tail->next = pcbs[i];
+        }
+        tail = pcbs[i];
+    }
+    queue_len += n;
+    RQ_UNLOCK();
+}
+
+static inline int heap_before(const PCB *a, const PCB *b) {
+    return a->deadline < b->deadline
+        || (a->deadline == b->deadline && a->deadline_seq < b->deadline_seq);
+}
+
+// RQ_LOCK held. 0 on success, -1 if the heap could not grow.
+static int heap_push(PCB *p) {
+    if (heap_len == heap_cap) {
+        int cap = heap_cap > 0 ? heap_cap * 2 : 16;
+        PCB **grown = realloc(heap, cap * sizeof(PCB *));
+        if (grown == NULL) {
+            return -1;
+        }
+        heap = grown;
+        heap_cap = cap;
+    }
+    p->next = NULL;
+    p->deadline_seq = heap_seq++;
+    int i = heap_len++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!heap_before(p, heap[parent])) {
+            break;
+        }
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = p;
+    return 0;
+}
+
+// RQ_LOCK held, heap_len > 0.
+static PCB *heap_pop(void) {
+    PCB *top = heap[0];
+    PCB *last = heap[--heap_len];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= heap_len) {
+            break;
+        }
+        if (child + 1 < heap_len && heap_before(heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!heap_before(heap[child], last)) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (heap_len > 0) {
+        heap[i] = last;
+    }
+    return top;
+}
+
+// EDF enqueue, ordered by p->deadline.
+void ready_queue_push_deadline(PCB *p) {
+    RQ_LOCK();
+    if (p != NULL) {
+        if (heap_push(p) != 0) {
+            // Out of memory: it still runs, in FIFO order behind the heap.
+            p->next = NULL;
+            if (tail == NULL) {
+                head = p;
+            } else {
+                tail->next = p;
+            }
+            tail = p;
+        }
+        queue_len++;
+    }
+    RQ_UNLOCK();
+}
+
+// EDF dequeue: the earliest deadline. PCBs that came in through the list
+// (spawned children, woken parents) join the heap first.
+PCB* ready_queue_pop_earliest(void) {
+    RQ_LOCK();
+    while (head != NULL) {
+        PCB *p = head;
+        head = p->next;
+        if (heap_push(p) != 0) {
+            head = p;
+            break;
+        }
+    }
+    if (head == NULL) {
+        tail = NULL;
+    }
+
+    PCB *p = NULL;
+    if (heap_len > 0) {
+        p = heap_pop();
+    } else if (head != NULL) {
+        p = head;
+        head = p->next;
+        if (head == NULL) {
+            tail = NULL;
+        }
+        p->next = NULL;
+    }
+    if (p != NULL) {
+        queue_len--;
+    }
+    RQ_UNLOCK();
+    return p;
+}
+
+static int heap_compare(const void *a, const void *b) {
+    const PCB *pa = *(PCB *const *)a, *pb = *(PCB *const *)b;
+    return heap_before(pa, pb) ? -1 : heap_before(pb, pa);
+}
+
+// checkpoint: the queued PCBs in the order they would run, the heap
+// first (by deadline) and then the list, in a malloc'd *out. Returns how
+// many, or -1 if out of memory. Nothing is dequeued.
+int ready_queue_collect(PCB ***out) {
+    RQ_LOCK();
+    int n = 0;
+    PCB **all = malloc((queue_len > 0 ? queue_len : 1) * sizeof(PCB *));
+    if (all != NULL) {
+        if (heap_len > 0) {
+            memcpy(all, heap, heap_len * sizeof(PCB *));
+            n = heap_len;
+            qsort(all, n, sizeof(PCB *), heap_compare);
+        }
+        for (PCB *p = head; p != NULL; p = p->next) {
+            all[n++] = p;
+        }
+    }
+    RQ_UNLOCK();
+    *out = all;
+    return all != NULL ? n : -1;
+}
+
+int ready_queue_length(void) {
+    RQ_LOCK();
+    int len = queue_len;
+    RQ_UNLOCK();
+    return len;
+}
+
 // Function for checking if queue is empty (thread-safe)
 int ready_queue_is_empty(void) {
-    pthread_mutex_lock(&rq_mutex);
-    int empty = (head == NULL);
-    pthread_mutex_unlock(&rq_mutex);
+    RQ_LOCK();
+    int empty = (head == NULL && heap_len == 0);
+    RQ_UNLOCK();
     return empty;
 }
 
 // print queue for debugging (still needs mutex for safe printing)
 void ready_queue_print() {
-    pthread_mutex_lock(&rq_mutex);
+    RQ_LOCK();
     
     PCB *curr = head;
     printf("Ready Queue: ");
@@ -237,5 +461,5 @@ void ready_queue_print() {
     }
     printf("NULL\n");
     
-    pthread_mutex_unlock(&rq_mutex);
+    RQ_UNLOCK();
 }
@@ -8,9 +8,16 @@ void ready_queue_add_to_head(PCB *p); // Helper for some policies
 PCB* ready_queue_pop_head();
 PCB* ready_queue_pop_shortest(); // Helper for SJF policy
 PCB* ready_queue_pop_pid(int pid); // 1.2.5: force one process to run first
+int ready_queue_contains_pid(int pid); // MT replay: is PID runnable
 void ready_queue_insert_sorted(PCB *p); // 1.2.4 AGING: score-sorted enqueue
 void ready_queue_age_all(void); // 1.2.4 AGING: age waiting jobs
 PCB* ready_queue_peek_head(void); // 1.2.4 AGING: promotion/continue check
+void ready_queue_push_deadline(PCB *p); // EDF: heap ordered by deadline
+PCB* ready_queue_pop_earliest(void); // EDF: earliest deadline first
+int ready_queue_pop_batch(PCB **out, int max); // MT batched dispatch
+void ready_queue_add_batch_to_tail(PCB **pcbs, int n); // MT batched requeue
+int ready_queue_collect(PCB ***out); // checkpoint: queued PCBs in run order
+int ready_queue_length(void);
 int ready_queue_is_empty(void); // Thread-safe check
 void ready_queue_print(); // Helper for debugging
 
@@ -0,0 +1,121 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "replaylog.h"
+
+#define REPLAY_MAGIC "MYSHRPL1"
+#define REPLAY_MAGIC_LEN 8
+#define RECORD_BUFFER 4096      // records per write while recording
+
+static FILE *record_file = NULL;
+static ReplayRecord *record_buf = NULL;
+static int record_len = 0;
+
+static ReplayRecord *replay_log = NULL;
+static int replay_len = 0;
+static int replay_pos = 0;
+static int replay_on = 0;
+
+static void replaylog_flush(void) {
+    if (record_len > 0) {
+        fwrite(record_buf, sizeof(ReplayRecord), record_len, record_file);
+        record_len = 0;
+    }
+}
+
+static void replaylog_close(void) {
+    if (record_file != NULL) {
+        replaylog_flush();
+        fclose(record_file);
+        record_file = NULL;
+    }
+    free(record_buf);
+    record_buf = NULL;
+}
+
+int replaylog_record_open(const char *path) {
+    record_buf = malloc(RECORD_BUFFER * sizeof(ReplayRecord));
+    record_file = fopen(path, "wb");
+    if (record_buf == NULL || record_file == NULL) {
+        replaylog_close();
+        return -1;
+    }
+    fwrite(REPLAY_MAGIC, 1, REPLAY_MAGIC_LEN, record_file);
+    // quit and end of input both leave through exit()
+    atexit(replaylog_close);
+    return 0;
+}
+
+static int record_cmp(const void *a, const void *b) {
+    uint32_t x = ((const ReplayRecord *)a)->seq;
+    uint32_t y = ((const ReplayRecord *)b)->seq;
+    return (x > y) - (x < y);
+}
+
+int replaylog_replay_open(const char *path) {
+    char magic[REPLAY_MAGIC_LEN];
+    FILE *f = fopen(path, "rb");
+    long size;
+
+    if (f == NULL) {
+        return -1;
+    }
+    if (fread(magic, 1, REPLAY_MAGIC_LEN, f) != REPLAY_MAGIC_LEN
+        || memcmp(magic, REPLAY_MAGIC, REPLAY_MAGIC_LEN) != 0
+        || fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0) {
+        fclose(f);
+        return -1;
+    }
+    replay_len = (size - REPLAY_MAGIC_LEN) / sizeof(ReplayRecord);
+    replay_log = malloc((replay_len > 0 ? replay_len : 1) * sizeof(ReplayRecord));
+    fseek(f, REPLAY_MAGIC_LEN, SEEK_SET);
+    if (replay_log == NULL
+        || fread(replay_log, sizeof(ReplayRecord), replay_len, f) != (size_t)replay_len) {
+        free(replay_log);
+        replay_log = NULL;
+        fclose(f);
+        return -1;
+    }
+    fclose(f);
+    // Workers append when their slice ends, so the file is only roughly in
+    // dispatch order.
+    qsort(replay_log, replay_len, sizeof(ReplayRecord), record_cmp);
+    replay_pos = 0;
+    replay_on = 1;
+    return 0;
+}
+
+int replaylog_recording(void) {
+    return record_file != NULL;
+}
+
+int replaylog_replaying(void) {
+    return replay_on;
+}
+
+void replaylog_append(const ReplayRecord *r) {
+    record_buf[record_len++] = *r;
+    if (record_len == RECORD_BUFFER) {
+        replaylog_flush();
+    }
+}
+
+const ReplayRecord *replaylog_peek(void) {
+    return replay_pos < replay_len ? &replay_log[replay_pos] : NULL;
+}
+
+void replaylog_advance(void) {
+    replay_pos++;
+}
+
+void replaylog_stop_replay(const char *why) {
+    if (replay_pos < replay_len) {
+        fprintf(stderr, "mysh: replay stopped at slice %d of %d: %s\n",
+                replay_pos, replay_len, why);
+    }
+    replay_on = 0;
+    free(replay_log);
+    replay_log = NULL;
+    replay_len = replay_pos = 0;
+}
@@ -0,0 +1,35 @@
+#ifndef REPLAYLOG_H
+#define REPLAYLOG_H
+
+#include <stdint.h>
+
+// Record/replay of MT scheduling (mysh --record FILE / --replay FILE).
+// Recording logs every slice an MT worker runs: which worker, which PID,
+// the pc range and how many commands it executed, keyed by the order the
+// slices were dispatched in. Replaying runs the same slices in that order,
+// one at a time, on the same workers, so a traced run can be reproduced.
+// The log is a "MYSHRPL1" magic followed by packed ReplayRecords.
+typedef struct {
+    uint32_t seq;       // dispatch order
+    int32_t pid;
+    int32_t pc_from;
+    int32_t pc_to;
+    uint32_t executed;  // commands run in the slice
+    uint16_t worker;
+    uint16_t flags;     // REPLAY_FINISHED
+} ReplayRecord;
+
+#define REPLAY_FINISHED 1
+
+int replaylog_record_open(const char *path);    // 0 on success
+int replaylog_replay_open(const char *path);    // 0 on success
+int replaylog_recording(void);
+int replaylog_replaying(void);
+
+// The scheduler calls these with its queue lock held.
+void replaylog_append(const ReplayRecord *r);
+const ReplayRecord *replaylog_peek(void);       // next slice, NULL at the end
+void replaylog_advance(void);
+void replaylog_stop_replay(const char *why);     // fall back to live scheduling
+
+#endif
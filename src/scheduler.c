@@ -4,25 +4,150 @@
 #include <unistd.h>
 #include <errno.h>
 #include <stdint.h>
+#include <time.h>
+#include <limits.h>
+#include <string.h>
 
 #include "scheduler.h"
 #include "shellmemory.h"
 #include "ready_queue.h"
 #include "shell.h"
+#include "affinity.h"
+#include "control.h"
+#include "slicetimer.h"
+#include "replaylog.h"
+#include "hotstats.h"
+#include "procinfo.h"
+#include "scriptload.h"
+#include "fairshare.h"
+#include "checkpoint.h"
 
 static int g_scheduler_active = 0;
 static SchedulePolicy g_current_policy = POLICY_FCFS;
 static int g_force_first_pid_once = -1;
+static int g_slice_ms = 0;  // exec ... TIMESLICE MS, 0 = instruction quanta
+// Instructions run by the shell thread's engine: the EDF clock, so
+// deadlines and lateness do not depend on machine speed.
+static long engine_clock = 0;
+static DeadlineStats deadline_stats;
+// checkpoint FILE [EVERY N]: taken by the policy loop between slices
+static int checkpoint_armed = 0;
+static int checkpoint_pending = 0;
+static long checkpoint_every = 0;  // engine instructions, 0 = once
+static long checkpoint_next = 0;
+static char checkpoint_path[4096];
 
 // Multithreaded scheduler globals
 static int mt_enabled = 0;
-static pthread_t worker_threads[2];
+static pthread_t worker_threads[MT_WORKERS];
+static WorkerStats *worker_stats[MT_WORKERS];  // Node-local; updated under rq_mutex
 static pthread_mutex_t rq_mutex = PTHREAD_MUTEX_INITIALIZER;  // Queue mutex
 static pthread_cond_t rq_cond = PTHREAD_COND_INITIALIZER;  // Condition variable
 static int scheduler_quit = 0;
+static int workers_started = 0;
+static int mt_time_slice = 2;  // Quantum used by the workers, set per exec
+static int mt_slice_ms = 0;  // TIMESLICE quantum for the workers, 0 = off
+static int mt_batch_size = 1;  // PCBs taken per queue lock (mysh --batch)
 static int active_jobs = 0;  // Count of jobs currently being executed
+static uint32_t dispatch_seq = 0;  // MT slices handed out, orders the replay log
+static pthread_cond_t idle_cond = PTHREAD_COND_INITIALIZER;  // MT queues drained
+
+// Idle workers spin on work_seq before they park on rq_cond, so a short
+// gap between slices costs no futex sleep and wakeup. Each worker adapts
+// its own spin between SPIN_MIN and SPIN_MAX pauses: doubled when spinning
+// found work, halved when it did not. With one CPU online spinning only
+// delays the thread that would queue the work, so it starts at 0 there.
+#define SPIN_MIN 64
+#define SPIN_MAX 16384
+#define SPIN_AUTO -1
+static int spin_start = SPIN_AUTO;  // mysh --spin N
+static unsigned work_seq = 0;  // bumped under rq_mutex whenever work is queued
+static int parked_workers = 0;  // workers in pthread_cond_wait on rq_cond
+static int wakes_pending = 0;  // of those, already signalled
+static long wakeups_sent = 0;  // parked workers signalled
+
+// Soft affinity: a preempted PCB goes back on its batch's list for the
+// worker that ran it (see fairshare.c), so it resumes there with its code
+// lines and variables still in that core's cache.
+static int mt_local_queues = 1;  // 0 = mysh --global-queue
 // Note: for the fcfs function in the video, please see line 41 onwards
 
+// Scheduler lock, counted under make STATS=1: every acquisition, and the
+// cycles spent waiting when it was contended.
+static inline void rq_lock(void) {
+#ifdef MYSH_STATS
+    if (pthread_mutex_trylock(&rq_mutex) == 0) {
+        hotstats_add(HS_SCHED_LOCK, 0);
+        return;
+    }
+    HOTSTAT_START(t0);
+    pthread_mutex_lock(&rq_mutex);
+    HOTSTAT_STOP(HS_SCHED_LOCK, t0);
+#else
+    pthread_mutex_lock(&rq_mutex);
+#endif
+}
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// rq_mutex held. More MT work is queued: spinning workers see work_seq
+// move, and parked ones are woken, all of them or just one.
+static void mt_wake(int all) {
+    __atomic_add_fetch(&work_seq, 1, __ATOMIC_RELEASE);
+    int asleep = parked_workers - wakes_pending;
+    if (asleep <= 0) {
+        return;
+    }
+    int n = all ? asleep : 1;
+    wakes_pending += n;
+    wakeups_sent += n;
+    if (n > 1) {
+        pthread_cond_broadcast(&rq_cond);
+    } else {
+        pthread_cond_signal(&rq_cond);
+    }
+}
+
+// rq_mutex not held. Up to budget pauses for work_seq to move past seen.
+static int spin_for_work(unsigned seen, int budget) {
+    for (int i = 0; i < budget; i++) {
+        if (__atomic_load_n(&work_seq, __ATOMIC_ACQUIRE) != seen) {
+            return 1;
+        }
+        cpu_relax();
+    }
+    return 0;
+}
+
+// Nothing runnable on any MT queue.
+static int mt_queues_empty(void) {
+    return share_queued() == 0 && ready_queue_is_empty();
+}
+
+// rq_mutex held. Up to want PCBs for worker id. New arrivals and woken
+// parents are on the ready queue; they join their batch's queue first, and
+// the batch that is furthest behind its share supplies the slices.
+static int mt_take(int id, PCB *batch[], int want) {
+    PCB *p;
+    while ((p = ready_queue_pop_head()) != NULL) {
+        share_enqueue(p);
+    }
+    return share_take(id, batch, want);
+}
+
+// Parent/child bookkeeping for nested source/exec. Lock order is
+// rq_mutex -> family_mutex -> the ready queue's own lock.
+static pthread_mutex_t family_mutex = PTHREAD_MUTEX_INITIALIZER;
+static __thread PCB *current_pcb = NULL;  // PCB this thread is running
+static __thread int slice_executed = 0;  // commands run by the last slice
+static __thread int current_worker = -1;  // MT worker id, -1 on the shell thread
+
 // Background globals
 static int background_jobs_active = 0;
 static pthread_mutex_t bg_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -37,23 +162,6 @@ static pthread_mutex_t bg_mutex = PTHREAD_MUTEX_INITIALIZER;
 static PCB* scheduler_pop_forced_first_if_any(void);
 // Forward declaration for 1.2.6
 static void* scheduler_worker_thread(void* arg);
-static int run_process_slice(PCB *current, int max_instructions, int last_error);
-
-static int scheduler_run_fcfs(void) {
-    // 1.2.1 base scheduler behavior. 1.2.2 exec FCFS also lands here
-    int last_error = 0;
-    PCB *current = NULL;
-
-    while ((current = scheduler_pop_forced_first_if_any()) != NULL
-           || (current = ready_queue_pop_head()) != NULL) {
-        last_error = run_process_slice(current, -1, last_error);
-
-        mem_cleanup_script(current->start, current->end);
-        free(current);
-    }
-
-    return last_error;
-}
 
 // Pop forced-first process if any
 static PCB* scheduler_pop_forced_first_if_any(void) {
@@ -66,128 +174,430 @@ static PCB* scheduler_pop_forced_first_if_any(void) {
     return forced;
 }
 
-// 1.2.3 helper. also reused by 1.2.4 aging loop
+// Runs the line at current->pc. Returns the instructions it counts against
+// the quantum and quota: 1 for a command or for an end that loops back, 0
+// for any other repeat/if/end line, which only moves pc forward. Counting
+// the back-edges bounds every slice, even for a loop that runs no command.
+static inline int run_instruction(PCB *current, int *last_error) {
+    CodeLine *code = mem_get_code(current->pc);
+    if (code->op != OP_CMD) {
+        return control_step(current, code);
+    }
+    if (code->line == mem_unloaded_line) {
+        script_map_fill(current->map, current->pc);
+    }
+    if (code->line != NULL) {
+        *last_error = parseInput(code->line);
+    }
+    current->pc++;
+    return 1;
+}
+
+/*
+ * Quota accounting (see quota.h). A slice never runs past the program's
+ * instruction quota, and is charged its commands and, only when a time
+ * quota is set, its running time. A slice also stops as soon as a set
+ * goes over quota (quota_hit); the policy loop then applies the action.
+ */
+#define QUOTA_CHUNK 64  // FCFS/SJF slice length for a job under quota
+
+static inline long quota_clock(const PCB *current) {
+    struct timespec ts;
+    if (current->quota.max_ms <= 0) {
+        return 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static inline int quota_budget(const PCB *current, int max_instructions) {
+    long left = current->quota.max_instructions - current->used.instructions;
+    if (current->quota.max_instructions <= 0 || left >= max_instructions) {
+        return max_instructions;
+    }
+    return left > 0 ? (int)left : 0;
+}
+
+static inline void quota_charge_slice(PCB *current, int executed, long t0) {
+    current->used.instructions += executed;
+    if (t0 != 0) {
+        current->used.ns += quota_clock(current) - t0;
+    }
+    if ((current->quota.max_instructions | current->quota.max_ms) != 0
+        && current->pc <= current->end && current->quota_hit == QUOTA_OK) {
+        quota_check_slice(current);
+    }
+}
+
+// 1.2.3 helper. also reused by 1.2.4 aging loop and the MT workers
 static int run_process_slice(PCB *current, int max_instructions, int last_error) {
     int executed = 0;
+    int budget = quota_budget(current, max_instructions);
+    long t0 = quota_clock(current);
 
-    while (current->pc <= current->end
-           && (max_instructions < 0 || executed < max_instructions)) {
-        char *line = mem_get_line(current->pc);
-        if (line != NULL) {
-            last_error = parseInput(line);
-        }
-        current->pc++;
-        executed++;
+    mem_set_current_scope(current->vars);
+    current_pcb = current;
+    procinfo_publish(current, PS_RUNNING, current_worker);
+    while (current->pc <= current->end && executed < budget
+           && !current->waiting && !current->quota_hit) {
+        executed += run_instruction(current, &last_error);
+    }
+    current_pcb = NULL;
+    mem_set_current_scope(NULL);
+    slice_executed = executed;
+    quota_charge_slice(current, executed, t0);
+    if (current_worker < 0) {
+        __atomic_add_fetch(&engine_clock, executed, __ATOMIC_RELAXED);
     }
 
     return last_error;
 }
 
+// 1.2.1/1.2.3 FCFS and SJF never preempt, so they skip the slice counter
+static int run_process_to_end(PCB *current, int last_error) {
+    if (current->quota.max_ms > 0 || current->quota.max_instructions > 0) {
+        // Bounded slices, so a quota can stop a runaway job.
+        while (current->pc <= current->end && !current->waiting
+               && !current->quota_hit) {
+            last_error = run_process_slice(current, QUOTA_CHUNK, last_error);
+        }
+        return last_error;
+    }
 
+    mem_set_current_scope(current->vars);
+    current_pcb = current;
+    procinfo_publish(current, PS_RUNNING, current_worker);
+    while (current->pc <= current->end && !current->waiting
+           && !current->quota_hit) {
+        run_instruction(current, &last_error);
+    }
+    current_pcb = NULL;
+    mem_set_current_scope(NULL);
 
-// 1.2.3: SJF scheduler
-static int scheduler_run_sjf(void) {
-    int last_error = 0;
-    PCB *current = NULL;
+    return last_error;
+}
 
-    // Get next process - try forced first, then shortest job
-    while ((current = scheduler_pop_forced_first_if_any()) != NULL
-           || (current = ready_queue_pop_shortest()) != NULL) {
-        last_error = run_process_slice(current, -1, last_error);
+// TIMESLICE mode: run until this thread's slice timer fires, then yield at
+// the next instruction boundary. One command always runs, so a slice that
+// expires inside a slow command still makes progress. Without a timer the
+// slice is quantum instructions, as if TIMESLICE had not been given.
+static int run_process_timed(PCB *current, int slice_ms, int quantum, int last_error) {
+    int executed = 0;
+    int budget = quota_budget(current, INT_MAX);
+    long t0 = quota_clock(current);
 
-        mem_cleanup_script(current->start, current->end);
-        free(current);
+    if (slicetimer_arm(slice_ms) != 0) {
+        return run_process_slice(current, quantum, last_error);
     }
+    mem_set_current_scope(current->vars);
+    current_pcb = current;
+    procinfo_publish(current, PS_RUNNING, current_worker);
+    while (current->pc <= current->end && (executed == 0 || !slicetimer_fired)
+           && executed < budget && !current->waiting && !current->quota_hit) {
+        executed += run_instruction(current, &last_error);
+    }
+    slicetimer_disarm();
+    current_pcb = NULL;
+    mem_set_current_scope(NULL);
+    slice_executed = executed;
+    quota_charge_slice(current, executed, t0);
 
     return last_error;
 }
 
-// 1.2.3 + 1.2.5: RR core with configurable quantum (2 for RR, 30 for RR30)
-static int scheduler_run_rr_quantum(int quantum) {
-    int last_error = 0;
-    PCB *current = NULL;
+void scheduler_set_deadline(PCB *pcb, long relative) {
+    pcb->deadline = __atomic_load_n(&engine_clock, __ATOMIC_RELAXED) + relative;
+    pcb->deadline_own = 1;
+}
+
+void scheduler_get_deadline_stats(DeadlineStats *out) {
+    *out = deadline_stats;
+}
 
-    // Get next process - try forced first, then head of queue
-    while ((current = scheduler_pop_forced_first_if_any()) != NULL
-           || (current = ready_queue_pop_head()) != NULL) {
-        last_error = run_process_slice(current, quantum, last_error);
+PCB *scheduler_current_pcb(void) {
+    return current_pcb;
+}
 
-        if (current->pc > current->end) {
-            mem_cleanup_script(current->start, current->end);
-            free(current);
-        } else {
-            ready_queue_add_to_tail(current);
+/*
+ * Nested source/exec. A running program's source or exec does not re-enter
+ * the scheduler; the loaded programs are spawned as its children into the
+ * engine that is already running it. A waiting parent (source, or the wait
+ * builtin) leaves the ready queue once its slice ends and is put back at
+ * the head when its last child finishes, so it resumes right where a
+ * sourced script would have returned.
+ */
+void scheduler_spawn(PCB *parent, PCB *children[], int count, int wait) {
+    rq_lock();
+    pthread_mutex_lock(&family_mutex);
+    for (int i = 0; i < count; i++) {
+        children[i]->parent = parent;
+        children[i]->parent_pid = parent->pid;
+        if (parent->group != NULL) {
+            share_join(parent->group, children[i]);
         }
+        if (!children[i]->deadline_own) {
+            children[i]->deadline = parent->deadline;  // its parent's work
+        }
+        procinfo_publish(children[i], PS_READY, -1);
+    }
+    parent->children_alive += count;
+    if (wait) {
+        parent->waiting = 1;
     }
+    pthread_mutex_unlock(&family_mutex);
 
-    return last_error;
+    if (wait) {
+        // The sourced script runs next, in order.
+        for (int i = count - 1; i >= 0; i--) {
+            ready_queue_add_to_head(children[i]);
+        }
+    } else {
+        for (int i = 0; i < count; i++) {
+            if (g_current_policy == POLICY_AGING && !mt_enabled) {
+                ready_queue_insert_sorted(children[i]);
+            } else {
+                ready_queue_add_to_tail(children[i]);
+            }
+        }
+    }
+    mt_wake(1);
+    pthread_mutex_unlock(&rq_mutex);
 }
 
-// 1.2.4: AGING policy
-static int scheduler_run_aging(void) {
-    int last_error = 0;
-    PCB *current = NULL;
-    const int aging_quantum = 1;
-
-    while ((current = scheduler_pop_forced_first_if_any()) != NULL
-           || (current = ready_queue_pop_head()) != NULL) {
-        last_error = run_process_slice(current, aging_quantum, last_error);
+// wait builtin: block the running program until its children finish.
+void scheduler_wait_children(PCB *parent) {
+    pthread_mutex_lock(&family_mutex);
+    if (parent->children_alive > 0) {
+        parent->waiting = 1;
+    }
+    pthread_mutex_unlock(&family_mutex);
+}
 
-        if (current->pc > current->end) {
-            mem_cleanup_script(current->start, current->end);
-            free(current);
-            continue;
+// After a slice: returns 1 if current is waiting on children and now parked
+// (a child will requeue it), 0 if it should be requeued as usual. Its ps
+// state is published under family_mutex, so a child waking it cannot
+// publish READY first.
+static int scheduler_park_if_waiting(PCB *current) {
+    int parked = 0;
+    pthread_mutex_lock(&family_mutex);
+    if (current->waiting) {
+        if (current->children_alive > 0) {
+            current->parked = 1;
+            parked = 1;
+        } else {
+            current->waiting = 0;   // children finished during the slice
         }
+    }
+    procinfo_publish(current, parked ? PS_WAITING : PS_READY, -1);
+    pthread_mutex_unlock(&family_mutex);
+    return parked;
+}
 
-        // 1.2.4 exact rule: age waiting jobs, not the one that just ran
-        ready_queue_age_all();
+// A program ran off its end: free its code, wake or release its parent, and
+// free the PCB unless children still point at it.
+static void scheduler_finish(PCB *current) {
+    PCB *parent = current->parent;
+    int wake_parent = 0, free_parent = 0, free_self;
 
-        // if current still lowest/tied-lowest, keep running. else reinsert sorted and promote
-        PCB *next = ready_queue_peek_head();
-        if (next == NULL || next->job_length_score >= current->job_length_score) {
-            ready_queue_add_to_head(current);
-        } else {
-            ready_queue_insert_sorted(current);
+    share_leave(current);   // MT only, rq_mutex held
+    if (current->deadline_own) {
+        long late = __atomic_load_n(&engine_clock, __ATOMIC_RELAXED) - current->deadline;
+        deadline_stats.finished++;
+        if (late > 0) {
+            deadline_stats.missed++;
+            deadline_stats.total_lateness += late;
+            if (late > deadline_stats.max_lateness) {
+                deadline_stats.max_lateness = late;
+            }
         }
     }
+    mem_cleanup_script(current->start, current->end);
 
-    return last_error;
+    pthread_mutex_lock(&family_mutex);
+    if (parent != NULL && --parent->children_alive == 0) {
+        if (parent->parked) {
+            parent->parked = 0;
+            parent->waiting = 0;
+            wake_parent = 1;
+            procinfo_publish(parent, PS_READY, -1);
+        }
+        free_parent = parent->finished;
+    }
+    current->finished = 1;
+    free_self = (current->children_alive == 0);
+    if (!free_self) {
+        // Kept for its children's sake only; ps no longer lists it.
+        procinfo_slot_free(current->ps_slot);
+        current->ps_slot = -1;
+    }
+    pthread_mutex_unlock(&family_mutex);
+
+    if (wake_parent) {
+        ready_queue_add_to_head(parent);
+    }
+    if (free_parent) {
+        pcb_free(parent);
+    }
+    if (free_self) {
+        pcb_free(current);
+    }
 }
 
-static int scheduler_run_mt_rr(int time_slice) {
-    int slice_arg0 = time_slice;
-    int slice_arg1 = time_slice;
-    
-    scheduler_quit = 0;  // Reset quit flag
-    active_jobs = 0;  // Reset active job count
-    
-    pthread_create(&worker_threads[0], NULL, scheduler_worker_thread, &slice_arg0);
-    pthread_create(&worker_threads[1], NULL, scheduler_worker_thread, &slice_arg1);
-    
-    // Wait for all jobs to complete
-    while (1) {
-        pthread_mutex_lock(&rq_mutex);
-        int queue_empty = ready_queue_is_empty();
-        int jobs_active = active_jobs;
-        int should_quit = scheduler_quit;
-        pthread_mutex_unlock(&rq_mutex);
-        
-        // If queue is empty and no jobs are being executed, we're done
-        if (queue_empty && jobs_active == 0) {
-            break;
+// Writes the ready queue as it stands. Called between slices or at the
+// prompt, when every runnable program is on it.
+static int checkpoint_take(void) {
+    PCB **pcbs;
+    int n = ready_queue_collect(&pcbs);
+    if (n < 0) {
+        return -1;
+    }
+    int rc = checkpoint_write(checkpoint_path, pcbs, n, g_current_policy, g_slice_ms,
+                              __atomic_load_n(&engine_clock, __ATOMIC_RELAXED));
+    free(pcbs);
+    return rc;
+}
+
+static void checkpoint_boundary(void) {
+    long now = __atomic_load_n(&engine_clock, __ATOMIC_RELAXED);
+    if (!checkpoint_pending && now < checkpoint_next) {
+        return;
+    }
+    checkpoint_pending = 0;
+    if (checkpoint_take() != 0) {
+        fprintf(stderr, "checkpoint: cannot write %s\n", checkpoint_path);
+        checkpoint_armed = 0;
+    } else if (checkpoint_every > 0) {
+        checkpoint_next = now + checkpoint_every;
+    } else {
+        checkpoint_armed = 0;
+    }
+}
+
+/*
+ * Generic scheduling engine. A policy is three compile-time pieces:
+ *   POP        takes the next PCB off the ready queue
+ *   QUANTUM    instructions per slice, SLICE_UNBOUNDED to run to the end,
+ *              or SLICE_TIMED for the exec's TIMESLICE wall-clock quantum
+ *   REQUEUE    puts a preempted PCB back
+ * DEFINE_POLICY_LOOP expands them into one tight loop per policy, so the
+ * constant QUANTUM folds away the unused slice path and the forced-first
+ * check (1.2.5) runs once on entry instead of on every pop.
+ * Adding a policy is one DEFINE_POLICY_LOOP line plus a policy_loops entry.
+ */
+#define SLICE_UNBOUNDED 0
+#define SLICE_TIMED -1
+
+#define DEFINE_POLICY_LOOP(name, POP, QUANTUM, REQUEUE)                     \
+static int name(void) {                                                     \
+    int last_error = 0;                                                     \
+    PCB *current = scheduler_pop_forced_first_if_any();                     \
+    if (current == NULL) current = POP();                                   \
+                                                                            \
+    while (current != NULL) {                                               \
+        if ((QUANTUM) == SLICE_UNBOUNDED) {                                 \
+            last_error = run_process_to_end(current, last_error);          \
+        } else if ((QUANTUM) == SLICE_TIMED) {                              \
+            last_error = run_process_timed(current, g_slice_ms,             \
+                g_current_policy == POLICY_RR30 ? 30 : 2, last_error);      \
+        } else {                                                            \
+            last_error = run_process_slice(current, (QUANTUM), last_error); \
+        }                                                                   \
+                                                                            \
+        int demoted = current->quota_hit && quota_enforce(current);         \
+        if (current->pc > current->end) {                                   \
+            scheduler_finish(current);                                      \
+        } else if (!scheduler_park_if_waiting(current)) {                   \
+            if (demoted) {                                                  \
+                ready_queue_add_to_tail(current);                           \
+            } else {                                                        \
+                REQUEUE(current);                                           \
+            }                                                               \
+        }                                                                   \
+        if (checkpoint_armed) checkpoint_boundary();                        \
+        current = POP();                                                    \
+    }                                                                       \
+                                                                            \
+    return last_error;                                                      \
+}
+
+
+// 1.2.4: AGING requeue
+static void requeue_aging(PCB *current) {
+    // 1.2.4 exact rule: age waiting jobs, not the one that just ran
+    ready_queue_age_all();
+
+    // if current still lowest/tied-lowest, keep running. else reinsert sorted and promote
+    PCB *next = ready_queue_peek_head();
+    if (next == NULL || next->job_length_score >= current->job_length_score) {
+        ready_queue_add_to_head(current);
+    } else {
+        ready_queue_insert_sorted(current);
+    }
+}
+
+// EDF: one instruction per slice, so a program spawned with an earlier
+// deadline takes over at once. Equal deadlines take turns.
+static void requeue_edf(PCB *current) {
+    ready_queue_push_deadline(current);
+}
+
+// 1.2.1 base scheduler behavior. 1.2.2 exec FCFS also lands here
+// FCFS/SJF only stop early for a program whose children finished while it
+// was starting to wait; it simply carries on first.
+DEFINE_POLICY_LOOP(scheduler_run_fcfs, ready_queue_pop_head, SLICE_UNBOUNDED, ready_queue_add_to_head)
+// 1.2.3: SJF scheduler
+DEFINE_POLICY_LOOP(scheduler_run_sjf, ready_queue_pop_shortest, SLICE_UNBOUNDED, ready_queue_add_to_head)
+// 1.2.3 + 1.2.5: RR with quantum 2, RR30 with quantum 30
+DEFINE_POLICY_LOOP(scheduler_run_rr, ready_queue_pop_head, 2, ready_queue_add_to_tail)
+DEFINE_POLICY_LOOP(scheduler_run_rr30, ready_queue_pop_head, 30, ready_queue_add_to_tail)
+// RR/RR30 with TIMESLICE: quantum measured in milliseconds, not instructions
+DEFINE_POLICY_LOOP(scheduler_run_rr_timed, ready_queue_pop_head, SLICE_TIMED, ready_queue_add_to_tail)
+// 1.2.4: AGING policy, one instruction per slice
+DEFINE_POLICY_LOOP(scheduler_run_aging, ready_queue_pop_head, 1, requeue_aging)
+// Earliest deadline first
+DEFINE_POLICY_LOOP(scheduler_run_edf, ready_queue_pop_earliest, 1, requeue_edf)
+
+static int (*const policy_loops[])(void) = {
+    [POLICY_FCFS] = scheduler_run_fcfs,
+    [POLICY_SJF] = scheduler_run_sjf,
+    [POLICY_RR] = scheduler_run_rr,
+    [POLICY_AGING] = scheduler_run_aging,
+    [POLICY_RR30] = scheduler_run_rr30,
+    [POLICY_EDF] = scheduler_run_edf,
+};
+
+// Workers are created once and then stay parked on rq_cond between execs,
+// so a long-running shell (see server.c) keeps its pool warm instead of
+// paying pthread_create/pthread_join on every exec.
+static void scheduler_start_workers(int time_slice) {
+    rq_lock();
+    mt_time_slice = time_slice;
+    mt_slice_ms = g_slice_ms;
+    scheduler_quit = 0;
+    if (spin_start == SPIN_AUTO) {
+        spin_start = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? 1024 : 0;
+    }
+    if (!workers_started) {
+        for (int i = 0; i < MT_WORKERS; i++) {
+            pthread_create(&worker_threads[i], NULL, scheduler_worker_thread,
+                           (void*)(intptr_t)i);
         }
-        usleep(1000);
+        workers_started = 1;
     }
-    
-    // Tell threads to quit
-    pthread_mutex_lock(&rq_mutex);
-    scheduler_quit = 1;
-    pthread_cond_broadcast(&rq_cond);  // Wake any waiting threads
+    mt_wake(1);  // New work may already be queued
     pthread_mutex_unlock(&rq_mutex);
+}
+
+static int scheduler_run_mt_rr(int time_slice) {
+    scheduler_start_workers(time_slice);
     
-    // Wait for threads to finish
-    pthread_join(worker_threads[0], NULL); 
-    pthread_join(worker_threads[1], NULL);
+    // Wait for all jobs to complete; the worker that runs the last slice
+    // signals idle_cond.
+    rq_lock();
+    while (!mt_queues_empty() || active_jobs > 0) {
+        pthread_cond_wait(&idle_cond, &rq_mutex);
+    }
+    pthread_mutex_unlock(&rq_mutex);
     
     return 0;
 }
@@ -195,11 +605,8 @@ static int scheduler_run_mt_rr(int time_slice) {
 
 // Non-blocking MT scheduler for background mode
 static int scheduler_run_mt_rr_nonblocking(int time_slice) {
-    scheduler_quit = 0;  // Reset quit flag
-    active_jobs = 0;  // Reset active job count
     // dont set g_scheduler_active = 1 here because its background
-    pthread_create(&worker_threads[0], NULL, scheduler_worker_thread, (void*)(intptr_t)time_slice);
-    pthread_create(&worker_threads[1], NULL, scheduler_worker_thread, (void*)(intptr_t)time_slice);
+    scheduler_start_workers(time_slice);
     
     return 0;
 }
@@ -220,31 +627,91 @@ int scheduler_run(SchedulePolicy policy) {
     g_current_policy = policy;
 
     // 1.2.2 policy dispatch entrypoint used by exec/source path
-    switch (policy) {
-    case POLICY_FCFS:
-        rc = scheduler_run_fcfs();
-        break;
-    case POLICY_SJF:
-        rc = scheduler_run_sjf();
-        break;
-    case POLICY_RR:
-        rc = scheduler_run_rr_quantum(2);
-        break;
-    case POLICY_RR30:
-        rc = scheduler_run_rr_quantum(30);
-        break;
-    case POLICY_AGING:
-        rc = scheduler_run_aging();
-        break;
-    default:
-        rc = 1;
-        break;
+    if (g_slice_ms > 0 && (policy == POLICY_RR || policy == POLICY_RR30)) {
+        rc = scheduler_run_rr_timed();
+    } else if ((unsigned)policy < sizeof(policy_loops) / sizeof(policy_loops[0])
+        && policy_loops[policy] != NULL) {
+        rc = policy_loops[policy]();
     }
 
     g_scheduler_active = 0;
     return rc;
 }
 
+// checkpoint FILE [EVERY N]. A running program's checkpoint is taken once
+// its slice ends, so the snapshot resumes at a slice boundary. The MT
+// engine is not covered: its programs are spread over the workers.
+int scheduler_checkpoint(const char *path, long every) {
+    if (path == NULL) {
+        checkpoint_armed = 0;   // checkpoint OFF
+        return 0;
+    }
+    if (current_worker >= 0 || (current_pcb == NULL && scheduler_is_active())
+        || strlen(path) >= sizeof(checkpoint_path)) {
+        return -1;
+    }
+    strcpy(checkpoint_path, path);
+    checkpoint_every = every > 0 ? every : 0;
+    checkpoint_next = __atomic_load_n(&engine_clock, __ATOMIC_RELAXED) + checkpoint_every;
+    checkpoint_pending = 1;
+    checkpoint_armed = 1;
+    if (current_pcb == NULL) {
+        checkpoint_pending = 0;
+        checkpoint_armed = checkpoint_every > 0;
+        return checkpoint_take();
+    }
+    return 0;
+}
+
+int scheduler_restore(const char *path) {
+    PCB **pcbs;
+    int count, slice_ms;
+    SchedulePolicy policy;
+
+    if (current_pcb != NULL || scheduler_is_active()
+        || checkpoint_read(path, &pcbs, &count, &policy, &slice_ms,
+                           __atomic_load_n(&engine_clock, __ATOMIC_RELAXED)) != 0) {
+        return -1;
+    }
+    // Like an exec from the prompt without MT.
+    scheduler_disable_multithreaded();
+    g_slice_ms = slice_ms;
+    for (int i = 0; i < count; i++) {
+        procinfo_publish(pcbs[i], PS_READY, -1);
+        if (policy == POLICY_EDF) {
+            ready_queue_push_deadline(pcbs[i]);
+        } else {
+            ready_queue_add_to_tail(pcbs[i]);
+        }
+    }
+    free(pcbs);
+    return scheduler_run(policy);
+}
+
+struct ShareGroup *scheduler_batch_new(int weight) {
+    rq_lock();
+    struct ShareGroup *batch = share_group_new(weight);
+    pthread_mutex_unlock(&rq_mutex);
+    return batch;
+}
+
+void scheduler_batch_release(struct ShareGroup *batch) {
+    rq_lock();
+    share_group_release(batch);
+    pthread_mutex_unlock(&rq_mutex);
+}
+
+// exec ... MT hands each program over here once all of its scripts are in
+// (see load_and_schedule_programs); the workers start on the first one
+// while the rest are being admitted.
+void scheduler_admit(PCB *pcb, struct ShareGroup *batch, SchedulePolicy policy) {
+    rq_lock();
+    share_join(batch, pcb);
+    ready_queue_add_to_tail(pcb);
+    pthread_mutex_unlock(&rq_mutex);
+    scheduler_start_workers(policy == POLICY_RR ? 2 : 30);
+}
+
 // Background mode scheduler: for MT, starts threads without waiting. For non-MT, returns immediately.
 int scheduler_run_background(SchedulePolicy policy) {
     if (mt_enabled && (policy == POLICY_RR || policy == POLICY_RR30)) {
@@ -258,8 +725,8 @@ int scheduler_run_background(SchedulePolicy policy) {
 int scheduler_is_active(void) {
     // In background mode, check if there are active jobs or non-empty queue
     if (mt_enabled) {
-        pthread_mutex_lock(&rq_mutex);
-        int has_work = (active_jobs > 0 || !ready_queue_is_empty());
+        rq_lock();
+        int has_work = (active_jobs > 0 || !mt_queues_empty());
         pthread_mutex_unlock(&rq_mutex);
         return has_work;
     }
@@ -274,6 +741,43 @@ void scheduler_set_first_process_pid(int pid) {
     g_force_first_pid_once = pid;
 }
 
+// exec ... TIMESLICE MS: RR/RR30 slices end on a per-thread timer instead
+// of an instruction count. 0 restores instruction quanta.
+void scheduler_set_time_slice_ms(int ms) {
+    g_slice_ms = ms > 0 ? ms : 0;
+}
+
+void scheduler_set_batch_size(int n) {
+    if (n < 1) n = 1;
+    if (n > MT_MAX_BATCH) n = MT_MAX_BATCH;
+    rq_lock();
+    mt_batch_size = n;
+    pthread_mutex_unlock(&rq_mutex);
+}
+
+// mysh --spin N: pauses an idle worker spins before parking, adapted from
+// there; 0 parks at once.
+void scheduler_set_spin(int n) {
+    rq_lock();
+    spin_start = n > SPIN_MAX ? SPIN_MAX : (n < 0 ? 0 : n);
+    pthread_mutex_unlock(&rq_mutex);
+}
+
+long scheduler_get_wakeups(void) {
+    rq_lock();
+    long n = wakeups_sent;
+    pthread_mutex_unlock(&rq_mutex);
+    return n;
+}
+
+// mysh --global-queue: MT workers share the one ready queue, and a
+// preempted PCB runs next on whichever worker is free.
+void scheduler_set_local_queues(int on) {
+    rq_lock();
+    mt_local_queues = on;
+    pthread_mutex_unlock(&rq_mutex);
+}
+
 void scheduler_enable_multithreaded() {
     mt_enabled = 1;
 }
@@ -286,65 +790,270 @@ int scheduler_is_multithreaded() {
     return mt_enabled;
 }
 
+// Snapshot of one worker's placement and counters. Returns 0 if the worker
+// is not running.
+int scheduler_get_worker_stats(int worker_id, WorkerStats *out) {
+    if (worker_id < 0 || worker_id >= MT_WORKERS) return 0;
+    rq_lock();
+    WorkerStats *ws = worker_stats[worker_id];
+    if (ws != NULL) {
+        *out = *ws;
+    }
+    pthread_mutex_unlock(&rq_mutex);
+    return ws != NULL;
+}
+
 // Wait for worker threads to finish (called on quit)
 void scheduler_join_workers() {
-    if (!mt_enabled) return;
+    if (!workers_started) return;
+    rq_lock();
     scheduler_quit = 1;
     pthread_cond_broadcast(&rq_cond);
-    pthread_join(worker_threads[0], NULL);
-    pthread_join(worker_threads[1], NULL);
+    pthread_mutex_unlock(&rq_mutex);
+    for (int i = 0; i < MT_WORKERS; i++) {
+        pthread_join(worker_threads[i], NULL);
+    }
+    workers_started = 0;
+}
+
+// rq_mutex held. Whether worker id has a slice to run. In replay, slices
+// run one at a time, each on the worker and in the order the log says.
+static int worker_has_work(int id) {
+    if (mt_queues_empty()) {
+        return 0;
+    }
+    if (!replaylog_replaying()) {
+        return 1;
+    }
+    const ReplayRecord *r = replaylog_peek();
+    if (r == NULL) {
+        replaylog_stop_replay("end of log");
+        pthread_cond_broadcast(&rq_cond);
+        return 1;
+    }
+    return active_jobs == 0 && r->worker % MT_WORKERS == id
+        && ready_queue_contains_pid(r->pid);
+}
+
+// rq_mutex held, replay only. Nothing is running and the next logged PID
+// still is not runnable after a grace period for the shell to queue it:
+// this run no longer matches the log.
+static void replay_wait(int id) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += 100 * 1000 * 1000;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    if (pthread_cond_timedwait(&rq_cond, &rq_mutex, &deadline) == ETIMEDOUT
+        && replaylog_replaying() && !worker_has_work(id) && active_jobs == 0
+        && !ready_queue_is_empty()) {
+        const ReplayRecord *r = replaylog_peek();
+        if (r != NULL && !ready_queue_contains_pid(r->pid)) {
+            replaylog_stop_replay("diverged from the log");
+            pthread_cond_broadcast(&rq_cond);
+        }
+    }
 }
 
 // 1.2.6 Worker thread function for MT RR/RR30
 static void* scheduler_worker_thread(void* arg) {
-    int time_slice = (int)(intptr_t)arg;
+    int id = (int)(intptr_t)arg;
+    int cpu = affinity_cpu_for_worker(id);
+
+    current_worker = id;
+
+    // Pin first so the stats block below is allocated on our own node.
+    if (cpu >= 0 && affinity_pin_self(cpu) != 0) {
+        fprintf(stderr, "mysh: could not pin worker %d to cpu %d\n", id, cpu);
+        cpu = -1;
+    }
+    WorkerStats *stats = affinity_alloc_local(sizeof(WorkerStats));
+    if (stats != NULL) {
+        stats->id = id;
+        stats->pinned = (cpu >= 0);
+        stats->cpu = affinity_current_cpu();
+        stats->node = affinity_current_node();
+    }
+    rq_lock();
+    worker_stats[id] = stats;
+    pthread_mutex_unlock(&rq_mutex);
+    
+    PCB *batch[MT_MAX_BATCH];
+    PCB *finished[MT_MAX_BATCH];
+    PCB *ran[MT_MAX_BATCH];
+    ReplayRecord log[MT_MAX_BATCH];
+    
+    int spin = 0;
     
     while (1) {
-        pthread_mutex_lock(&rq_mutex);
+        rq_lock();
+        
+        // Out of work: spin a while before parking (see SPIN_MIN)
+        if (spin_start > 0 && !scheduler_quit && !worker_has_work(id)
+            && !replaylog_replaying()) {
+            if (spin == 0) spin = spin_start;
+            unsigned seen = __atomic_load_n(&work_seq, __ATOMIC_RELAXED);
+            pthread_mutex_unlock(&rq_mutex);
+            int hit = spin_for_work(seen, spin);
+            rq_lock();
+            if (hit) {
+                spin = spin * 2 < SPIN_MAX ? spin * 2 : SPIN_MAX;
+                if (stats != NULL) stats->spin_hits++;
+            } else {
+                spin = spin / 2 > SPIN_MIN ? spin / 2 : SPIN_MIN;
+            }
+        }
         
         // Wait for work - but check quit condition properly
-        while (!scheduler_quit && ready_queue_is_empty()) {
-            pthread_cond_wait(&rq_cond, &rq_mutex);
+        while (!scheduler_quit && !worker_has_work(id)) {
+            if (replaylog_replaying() && !ready_queue_is_empty()) {
+                replay_wait(id);
+            } else {
+                parked_workers++;
+                if (stats != NULL) stats->parks++;
+                pthread_cond_wait(&rq_cond, &rq_mutex);
+                parked_workers--;
+                if (wakes_pending > 0) wakes_pending--;
+            }
         }
         
         // Check if we should quit (queue might be empty)
-        if (scheduler_quit && ready_queue_is_empty()) {
+        if (scheduler_quit && mt_queues_empty()) {
             pthread_mutex_unlock(&rq_mutex);
             break;
         }
         
-        // Get a process to run
-        PCB *current = ready_queue_pop_head();
-        if (current) {
-            active_jobs++;
+        // Get a batch of processes to run. Never take more than our share
+        // of the queue, so the other worker is not left idle while we sit
+        // on runnable processes.
+        int n;
+        int time_slice = mt_time_slice;
+        int slice_ms = mt_slice_ms;
+        int replay = replaylog_replaying();
+        int replay_pc_to = 0;
+        if (replay) {
+            // worker_has_work checked that the logged PID is queued
+            batch[0] = ready_queue_pop_pid(replaylog_peek()->pid);
+            time_slice = (int)replaylog_peek()->executed;
+            replay_pc_to = replaylog_peek()->pc_to;
+            slice_ms = 0;
+            replaylog_advance();
+            n = 1;
+        } else {
+            int want = mt_batch_size;
+            int share = (ready_queue_length() + share_queued() + MT_WORKERS - 1) / MT_WORKERS;
+            if (want > share) want = share;
+            n = mt_take(id, batch, want);
         }
+        uint32_t seq = dispatch_seq;
+        dispatch_seq += n;
+        active_jobs += n;
         pthread_mutex_unlock(&rq_mutex);
         
-        if (!current) continue;
-        
-        // Run the process slice
-        run_process_slice(current, time_slice, 0);
+        if (n == 0) continue;
         
-        // Check if process is complete
-        int is_done = (current->pc > current->end);
+        // Run one slice of each, in queue order. Unfinished processes are
+        // compacted to the front of batch so they go back in the same order.
+        int kept = 0, done = 0;
+        long ran_instructions = 0, ran_migrations = 0;
+        for (int i = 0; i < n; i++) {
+            PCB *current = batch[i];
+            int pc_before = current->pc;
+            ran[i] = current;
+            if (current->last_worker >= 0 && current->last_worker != id) {
+                ran_migrations++;
+            }
+            current->last_worker = id;
+            if (slice_ms > 0) {
+                run_process_timed(current, slice_ms, time_slice, 0);
+            } else {
+                run_process_slice(current, time_slice, 0);
+            }
+            ran_instructions += current->pc - pc_before;
+            log[i].seq = seq + i;
+            log[i].pid = current->pid;
+            log[i].pc_from = pc_before;
+            log[i].pc_to = current->pc;
+            log[i].executed = slice_executed;
+            log[i].worker = id;
+            log[i].flags = current->pc > current->end ? REPLAY_FINISHED : 0;
+            if (current->quota_hit) {
+                quota_enforce(current);   // demoting: it goes to the tail anyway
+            }
+            if (current->pc > current->end) {
+                finished[done++] = current;
+            } else if (!scheduler_park_if_waiting(current)) {
+                batch[kept++] = current;
+            }
+        }
+        int cpu = -1, node = -1;
+        if (stats != NULL && !stats->pinned) {
+            cpu = affinity_current_cpu();
+            node = affinity_current_node();
+        }
         
-        pthread_mutex_lock(&rq_mutex);
-        if (is_done) {
-            // Process finished - cleanup
-            mem_cleanup_script(current->start, current->end);
-            free(current);
-            active_jobs--;
+        rq_lock();
+        // schedstats copies the block under rq_mutex, so the counters of
+        // the batch go in here rather than as the slices run.
+        if (stats != NULL) {
+            stats->slices += n;
+            stats->instructions += ran_instructions;
+            stats->migrations += ran_migrations;
+            if (!stats->pinned) {
+                stats->cpu = cpu;
+                stats->node = node;
+            }
+        }
+        if (replaylog_recording()) {
+            for (int i = 0; i < n; i++) {
+                replaylog_append(&log[i]);
+            }
+        }
+        if (replay && log[0].pc_to != replay_pc_to && replaylog_replaying()) {
+            replaylog_stop_replay("diverged from the log");
+        }
+        if (!replay) {
+            for (int i = 0; i < n; i++) {
+                share_charge(ran[i], log[i].executed);
+            }
+        }
+        // Processes finished - cleanup
+        for (int i = 0; i < done; i++) {
+            scheduler_finish(finished[i]);
+        }
+        // Processes not done - back to queue. Replay finds the next PID on
+        // the global queue, so it keeps everything there.
+        if (!replaylog_replaying()) {
+            for (int i = 0; i < kept; i++) {
+                share_requeue(batch[i], mt_local_queues ? id : SHARE_SHARED);
+            }
         } else {
-            // Process not done - back to queue
-            ready_queue_add_to_tail(current);
-            active_jobs--;
+            ready_queue_add_batch_to_tail(batch, kept);
         }
+        active_jobs -= n;
         
-        // Signal that queue state has changed
-        pthread_cond_signal(&rq_cond);
+        // Signal that queue state has changed. A replayed slice may be due
+        // on either worker. Otherwise this worker takes the next slice
+        // itself, so another is woken only if two or more are waiting.
+        if (replay) {
+            pthread_cond_broadcast(&rq_cond);
+        } else if (share_queued() + ready_queue_length() >= 2) {
+            mt_wake(0);
+        }
+        if (active_jobs == 0 && mt_queues_empty()) {
+            pthread_cond_broadcast(&idle_cond);
+        }
         pthread_mutex_unlock(&rq_mutex);
     }
 
+    rq_lock();
+    worker_stats[id] = NULL;
+    pthread_mutex_unlock(&rq_mutex);
+    affinity_free_local(stats, sizeof(WorkerStats));
+    slicetimer_release();
+
     // When thread exits (all jobs done)
     pthread_mutex_lock(&bg_mutex);
     background_jobs_active--;
@@ -1,16 +1,50 @@
 #ifndef SCHEDULER_H
 #define SCHEDULER_H
 
+#include "pcb.h"
+
 typedef enum {
     POLICY_FCFS = 0,
     POLICY_SJF,
     POLICY_RR,
     POLICY_AGING,
-    POLICY_RR30
+    POLICY_RR30,
+    POLICY_EDF
 } SchedulePolicy;
 
+#define MT_WORKERS 2
+#define MT_MAX_BATCH 16
+
+// Per-worker placement and counters, reported by schedstats
+typedef struct {
+    int id;
+    int pinned;         // 1 if pinned with --cpus
+    int cpu;            // CPU the worker last ran on
+    int node;           // NUMA node of that CPU, -1 if unknown
+    long slices;
+    long instructions;
+    long migrations;    // slices of a PCB another worker ran last
+    long spin_hits;     // idle spins that found work before parking
+    long parks;         // times it slept on the queue's condition variable
+} WorkerStats;
+
+// Programs with an exec ... DEADLINE that finished, and how late
+typedef struct {
+    long finished;
+    long missed;
+    long max_lateness;      // instructions past the deadline, worst case
+    long total_lateness;    // summed over the missed ones
+} DeadlineStats;
+
 int scheduler_run(SchedulePolicy policy);
 int scheduler_run_background(SchedulePolicy policy);
+// Weighted batch for one MT exec (see fairshare.h); release it once all
+// its programs are admitted.
+struct ShareGroup *scheduler_batch_new(int weight);
+void scheduler_batch_release(struct ShareGroup *batch);
+// MT RR/RR30: queue one loaded program of batch and get the workers going
+// on it right away
+void scheduler_admit(PCB *pcb, struct ShareGroup *batch, SchedulePolicy policy);
 int scheduler_is_active(void);
 
 // Enable/disable multithreaded mode
@@ -20,5 +54,30 @@ void scheduler_disable_multithreaded();
 void scheduler_join_workers();
 // Check if multithreaded mode is enabled
 int scheduler_is_multithreaded();
+void scheduler_set_time_slice_ms(int ms);
+// PCBs an MT worker takes per queue lock acquisition (1..MT_MAX_BATCH)
+void scheduler_set_batch_size(int n);
+int scheduler_get_worker_stats(int worker_id, WorkerStats *out);
+// Pauses an idle worker spins before it parks (0: park at once)
+void scheduler_set_spin(int n);
+// Parked workers woken up for new work
+long scheduler_get_wakeups(void);
+// 1 (default): a preempted PCB stays on its worker's own queue
+void scheduler_set_local_queues(int on);
+// EDF: pcb is due relative instructions of the engine from now
+void scheduler_set_deadline(PCB *pcb, long relative);
+void scheduler_get_deadline_stats(DeadlineStats *out);
+// Snapshot the ready queue and variables to path now (at the prompt) or
+// once the running slice ends, then every `every` engine instructions if
+// every > 0. NULL path stops periodic snapshots. -1 if not possible here.
+int scheduler_checkpoint(const char *path, long every);
+// Load a snapshot at the prompt and run it. -1 if it cannot be loaded.
+int scheduler_restore(const char *path);
+// PCB the calling thread is running, NULL at the shell prompt
+PCB *scheduler_current_pcb(void);
+// Start children of a running program; wait=1 blocks it until they finish
+void scheduler_spawn(PCB *parent, PCB *children[], int count, int wait);
+// Block a running program until its children have finished
+void scheduler_wait_children(PCB *parent);
 
 #endif
@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <ctype.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "scriptload.h"
+#include "shell.h"
+#include "shellmemory.h"
+#include "progimage.h"
+#include "intern.h"
+
+#define SCRIPT_READAHEAD 16     // lines materialized per demand load
+#define SCRIPT_LINE_MAX (MAX_USER_INPUT - 2)    // longer lines split, as fgets did
+
+struct ScriptMap {
+    char *data;         // private copy of the script text, or the mapped image
+    size_t size;
+    int count;
+    int base;           // code memory index of line 0
+    const ProgImageHeader *prog;    // data is a compiled image, else NULL
+    int offsets[MEM_SIZE + 1];  // text only: line i is data[offsets[i], offsets[i + 1])
+};
+
+// repeat/if/end lines are linked at load time, so they are copied eagerly.
+static int is_control_line(const char *p, size_t len) {
+    static const char *const words[] = { "repeat", "if", "end" };
+    const char *end = p + len;
+
+    while (p < end && isspace((unsigned char)*p)) p++;
+    for (int i = 0; i < 3; i++) {
+        size_t n = strlen(words[i]);
+        if ((size_t)(end - p) >= n && memcmp(p, words[i], n) == 0
+            && (p + n == end || isspace((unsigned char)p[n]))) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Reads the script in one go and indexes its lines without interning
+// them. The text is a private copy rather than a mapping of the file, so
+// a program whose script is rewritten or truncated while it runs still
+// runs the script it was started with. Returns -1 if the file is not a
+// regular file or is empty, in which case it is read the old way.
+static int script_map(ScriptImage *img) {
+    struct stat st;
+    int fd = open(img->path, O_RDONLY);
+
+    if (fd < 0) {
+        return -1;
+    }
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+    char *data = malloc(st.st_size);
+    size_t size = 0;
+    while (data != NULL && size < (size_t)st.st_size) {
+        ssize_t n = read(fd, data + size, st.st_size - size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            img->error = -1;
+        }
+        if (n <= 0) {
+            break;      // or shrunk since the fstat: what was there
+        }
+        size += n;
+    }
+    close(fd);
+
+    ScriptMap *map = malloc(sizeof(ScriptMap));
+    img->lines = malloc(MEM_SIZE * sizeof(char *));
+    if (data == NULL || map == NULL || img->lines == NULL || img->error != 0) {
+        free(data);
+        free(map);
+        img->error = -1;
+        return 0;
+    }
+    map->data = data;
+    map->size = size;
+    map->base = -1;
+    map->prog = NULL;
+    img->map = map;
+
+    size_t off = 0;
+    while (off < map->size) {
+        if (img->count == MEM_SIZE) {
+            img->error = -1;    // could never fit in code memory
+            break;
+        }
+        size_t len = map->size - off;
+        if (len > SCRIPT_LINE_MAX) len = SCRIPT_LINE_MAX;
+        char *nl = memchr(data + off, '\n', len);
+        if (nl != NULL) len = nl - (data + off) + 1;
+
+        char *line = mem_unloaded_line;
+        if (is_control_line(data + off, len)) {
+            line = (char *)intern_n(data + off, len);
+            if (line == NULL) {
+                img->error = -1;
+                break;
+            }
+        }
+        map->offsets[img->count] = off;
+        img->lines[img->count++] = line;
+        off += len;
+    }
+    map->offsets[img->count] = off;
+    map->count = img->count;
+    return 0;
+}
+
+// A fresh SCRIPT.mshc (see progimage.h): the lines point into the image
+// and need no scan at all.
+static int script_map_compiled(ScriptImage *img) {
+    size_t size;
+    const ProgImageHeader *h = progimage_map(img->path, &size);
+
+    if (h == NULL) {
+        return -1;
+    }
+    ScriptMap *map = malloc(sizeof(ScriptMap));
+    img->lines = malloc((h->count > 0 ? h->count : 1) * sizeof(char *));
+    if (map == NULL || img->lines == NULL) {
+        free(map);
+        munmap((void *)h, size);
+        img->error = -1;
+        return 0;
+    }
+    map->data = (char *)h;
+    map->size = size;
+    map->count = h->count;
+    map->base = -1;
+    map->prog = h;
+    img->map = map;
+
+    const ProgImageOp *ops = progimage_ops(h);
+    const char *strtab = progimage_strtab(h);
+    for (int i = 0; i < h->count; i++) {
+        img->lines[i] = (char *)strtab + ops[i].str;
+    }
+    img->count = h->count;
+    img->cost = h->cost;
+    return 0;
+}
+
+void script_map_attach(ScriptMap *map, int base) {
+    map->base = base;
+    if (map->prog == NULL) {
+        return;
+    }
+    // Lines were placed by mem_load_script; add the precompiled links.
+    const ProgImageOp *ops = progimage_ops(map->prog);
+    for (int i = 0; i < map->count; i++) {
+        CodeLine *code = mem_get_code(base + i);
+        code->op = ops[i].op;
+        code->arg = ops[i].arg;
+        code->target = ops[i].target < 0 ? -1 : base + ops[i].target;
+        code->borrowed = 1;
+    }
+}
+
+void script_map_fill(ScriptMap *map, int index) {
+    int first = index - map->base;
+    int last = first + SCRIPT_READAHEAD;
+    if (last > map->count) last = map->count;
+
+    for (int i = first; i < last; i++) {
+        CodeLine *code = mem_get_code(map->base + i);
+        if (code->line != mem_unloaded_line) continue;
+        char *line = (char *)intern_n(map->data + map->offsets[i],
+                                      map->offsets[i + 1] - map->offsets[i]);
+        if (line == NULL) break;
+        // mem_cleanup_script looks at other scripts' slots under its lock
+        __atomic_store_n(&code->line, line, __ATOMIC_RELEASE);
+    }
+}
+
+void script_map_free(ScriptMap *map) {
+    if (map == NULL) return;
+    if (map->prog != NULL) {
+        munmap(map->data, map->size);
+    } else {
+        free(map->data);
+    }
+    free(map);
+}
+
+static void script_read(ScriptImage *img) {
+    char line[MAX_USER_INPUT];
+    int cap = 0;
+    FILE *p = fopen(img->path, "rt");
+
+    if (p == NULL) {
+        img->error = -1;
+        return;
+    }
+    while (fgets(line, MAX_USER_INPUT - 1, p) != NULL) {
+        if (img->count == MEM_SIZE) {
+            img->error = -1;    // could never fit in code memory
+            break;
+        }
+        if (img->count == cap) {
+            cap = cap ? cap * 2 : 64;
+            char **grown = realloc(img->lines, cap * sizeof(char *));
+            if (grown == NULL) {
+                img->error = -1;
+                break;
+            }
+            img->lines = grown;
+        }
+        img->lines[img->count] = (char *)intern(line);
+        if (img->lines[img->count] == NULL) {
+            img->error = -1;
+            break;
+        }
+        img->count++;
+    }
+    fclose(p);
+}
+
+static void *script_read_thread(void *arg) {
+    if (script_map_compiled(arg) != 0 && script_map(arg) != 0) {
+        script_read(arg);
+    }
+    return NULL;
+}
+
+void script_load_begin(ScriptImage images[], char *paths[], int count) {
+    for (int i = 0; i < count; i++) {
+        images[i].path = paths[i];
+        images[i].lines = NULL;
+        images[i].count = 0;
+        images[i].error = 0;
+        images[i].threaded = 0;
+        images[i].map = NULL;
+        images[i].cost = -1;
+    }
+    // Reader threads only pay off if they can read at the same time.
+    int parallel = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+    for (int i = 1; i < count && parallel; i++) {
+        if (pthread_create(&images[i].thread, NULL, script_read_thread,
+                           &images[i]) == 0) {
+            images[i].threaded = 1;
+        }
+    }
+    // The first script, and any that did not get a thread, on the caller.
+    for (int i = 0; i < count; i++) {
+        if (!images[i].threaded) {
+            script_read_thread(&images[i]);
+        }
+    }
+}
+
+int script_load_wait(ScriptImage *img) {
+    if (img->threaded) {
+        pthread_join(img->thread, NULL);
+        img->threaded = 0;
+    }
+    return img->error;
+}
+
+void script_image_free(ScriptImage *img) {
+    script_load_wait(img);
+    for (int i = 0; i < img->count && !(img->map && img->map->prog); i++) {
+        if (img->lines[i] != mem_unloaded_line) {
+            intern_release(img->lines[i]);
+        }
+    }
+    free(img->lines);
+    img->lines = NULL;
+    img->count = 0;
+    script_map_free(img->map);
+    img->map = NULL;
+}
@@ -0,0 +1,44 @@
+#ifndef SCRIPTLOAD_H
+#define SCRIPTLOAD_H
+
+#include <pthread.h>
+
+// Script reading for exec/source. Each script of a multi-program exec is
+// read into its own line array on its own thread, so the exec waits for
+// the slowest file instead of the sum of them. Code memory is filled
+// afterwards, a whole script at a time (mem_load_script).
+//
+// Regular files are read whole into a private buffer: loading only indexes
+// the line offsets and copies the repeat/if/end lines, and every other line
+// stays mem_unloaded_line until the program's pc first reaches it. The PCB
+// keeps the buffer (PCB.map) until it is freed, so the file can change
+// under a running program. A fresh compiled image of the script
+// (progimage.h) is mapped instead of the text when there is one.
+typedef struct ScriptMap ScriptMap;
+
+typedef struct {
+    const char *path;
+    char **lines;       // interned lines, handed over to mem_load_script
+    ScriptMap *map;     // mapped file, handed over to the PCB; else NULL
+    int cost;           // job length if read from a compiled image, else -1
+    int count;
+    int error;          // 0, or -1 if the file cannot be read or cannot fit
+    pthread_t thread;
+    int threaded;       // reader thread still to be joined
+} ScriptImage;
+
+// Starts reading every script; the first one is read by the caller.
+void script_load_begin(ScriptImage images[], char *paths[], int count);
+// Waits for one script. 0 once its lines are ready, -1 on error.
+int script_load_wait(ScriptImage *img);
+// Waits if needed and frees the lines and map still owned.
+void script_image_free(ScriptImage *img);
+
+// Sets the code memory index the script was loaded at. For a compiled
+// image, also fills in the control links of its code lines.
+void script_map_attach(ScriptMap *map, int base);
+// Copies in the unloaded line at index, plus a few lines of read-ahead.
+void script_map_fill(ScriptMap *map, int index);
+void script_map_free(ScriptMap *map);
+
+#endif
@@ -0,0 +1,202 @@
+#define _GNU_SOURCE             // accept4
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "server.h"
+#include "shell.h"
+
+#define SERVER_MAX_CLIENTS 64
+
+typedef struct {
+    int fd;
+    int len;                    // Bytes buffered in buf
+    int eof;                    // Client finished sending
+    int closing;                // quit was requested on this connection
+    char buf[MAX_USER_INPUT];
+} Client;
+
+static Client clients[SERVER_MAX_CLIENTS];
+static int client_count = 0;
+static int serving = 0;
+static Client *current_client = NULL;
+
+int server_is_serving(void) {
+    return serving;
+}
+
+void server_close_current(void) {
+    if (current_client != NULL) {
+        current_client->closing = 1;
+    }
+}
+
+static int server_listen(const char *socket_path) {
+    struct sockaddr_un addr;
+    int fd;
+
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "mysh: socket path too long: %s\n", socket_path);
+        return -1;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("mysh: socket");
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    unlink(socket_path);        // stale socket from a previous run
+
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0
+        || listen(fd, SERVER_MAX_CLIENTS) < 0) {
+        perror("mysh: bind/listen");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void server_drop_client(int i) {
+    close(clients[i].fd);
+    clients[i] = clients[client_count - 1];
+    client_count--;
+}
+
+// Returns the length of the first complete line in c->buf (including the
+// newline), or 0 if there is none yet. A full buffer with no newline, or an
+// unterminated last line, is handed over as is, like fgets in batch mode.
+static int server_next_line(Client *c) {
+    char *nl = memchr(c->buf, '\n', c->len);
+    if (nl != NULL) {
+        return (int) (nl - c->buf) + 1;
+    }
+    if (c->len >= MAX_USER_INPUT - 1 || c->eof) {
+        return c->len;
+    }
+    return 0;
+}
+
+// Run one command line for client c with stdout redirected to its socket.
+static void server_run_line(Client *c, int line_len) {
+    char line[MAX_USER_INPUT];
+    int saved_stdout;
+
+    memcpy(line, c->buf, line_len);
+    line[line_len] = '\0';
+    memmove(c->buf, c->buf + line_len, c->len - line_len);
+    c->len -= line_len;
+
+    fflush(stdout);
+    saved_stdout = dup(STDOUT_FILENO);
+    dup2(c->fd, STDOUT_FILENO);
+
+    current_client = c;
+    parseInput(line);
+    current_client = NULL;
+
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(saved_stdout);
+
+    // End-of-response marker
+    if (write(c->fd, "", 1) != 1) {
+        c->closing = 1;
+    }
+}
+
+int server_run(const char *socket_path) {
+    struct pollfd fds[SERVER_MAX_CLIENTS + 1];
+    int listen_fd = server_listen(socket_path);
+
+    if (listen_fd < 0) {
+        return 1;
+    }
+    // A client hanging up mid-response must not kill the server.
+    signal(SIGPIPE, SIG_IGN);
+    serving = 1;
+
+    while (1) {
+        int pending = 0;
+
+        // Clients that already have a full line buffered are served
+        // without waiting in poll.
+        for (int i = 0; i < client_count; i++) {
+            if (server_next_line(&clients[i]) > 0) {
+                pending = 1;
+            }
+        }
+
+        fds[0].fd = listen_fd;
+        fds[0].events = POLLIN;
+        for (int i = 0; i < client_count; i++) {
+            fds[i + 1].fd = clients[i].eof ? -1 : clients[i].fd;
+            fds[i + 1].events = POLLIN;
+            fds[i + 1].revents = 0;
+        }
+
+        if (poll(fds, client_count + 1, pending ? 0 : -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            perror("mysh: poll");
+            break;
+        }
+
+        // Read whatever arrived. fds[i + 1] lines up with clients[i].
+        for (int i = 0; i < client_count; i++) {
+            Client *c = &clients[i];
+            if (!(fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            int space = MAX_USER_INPUT - 1 - c->len;
+            if (space <= 0) {
+                continue;       // Drained below before we read more
+            }
+            int n = read(c->fd, c->buf + c->len, space);
+            if (n > 0) {
+                c->len += n;
+            } else if (n == 0 || errno != EINTR) {
+                c->eof = 1;
+            }
+        }
+
+        // One line per client per round keeps a chatty client from
+        // starving the others.
+        for (int i = client_count - 1; i >= 0; i--) {
+            int line_len = server_next_line(&clients[i]);
+            if (line_len > 0) {
+                server_run_line(&clients[i], line_len);
+            }
+            if (clients[i].closing || (clients[i].eof && clients[i].len == 0)) {
+                server_drop_client(i);
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+            if (fd >= 0 && client_count < SERVER_MAX_CLIENTS) {
+                clients[client_count].fd = fd;
+                clients[client_count].len = 0;
+                clients[client_count].eof = 0;
+                clients[client_count].closing = 0;
+                client_count++;
+            } else if (fd >= 0) {
+                close(fd);      // full, client sees EOF
+            }
+        }
+    }
+
+    close(listen_fd);
+    unlink(socket_path);
+    serving = 0;
+    return 1;
+}
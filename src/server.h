@@ -0,0 +1,16 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+/*
+ * Service mode (mysh --serve PATH).
+ * Clients connect to a Unix domain socket and send one shell command per
+ * line, exactly as they would be typed in batch mode. Each command runs in
+ * the long-lived shell (same variable store, same scheduler workers) with
+ * stdout pointed at the client, and its output is followed by a single
+ * '\0' byte so the client knows the request is complete.
+ */
+int server_run(const char *socket_path);
+int server_is_serving(void);
+void server_close_current(void); // quit closes the connection, not the shell
+
+#endif
@@ -3,25 +3,133 @@
 #include <ctype.h>              // isspace
 #include <string.h>
 #include <unistd.h>             // isatty
+#include <errno.h>
+#include <limits.h>
 #include "shell.h"
 #include "interpreter.h"
 #include "shellmemory.h"
+#include "server.h"
+#include "affinity.h"
+#include "scheduler.h"
+#include "linereader.h"
+#include "replaylog.h"
+#include "hotstats.h"
+#include "tokenizer.h"
+#include "progimage.h"
 
 int parseInput(char ui[]);
 
+// A whole decimal number in [min, max] into *out; 0 on success, -1 if s is
+// anything else.
+static int parse_int_arg(const char *s, long min, long max, int *out) {
+    char *end;
+    errno = 0;
+    long v = strtol(s, &end, 10);
+    if (errno != 0 || end == s || *end != '\0' || v < min || v > max) {
+        return -1;
+    }
+    *out = (int)v;
+    return 0;
+}
+
+static int usage(const char *prog) {
+    fprintf(stderr, "usage: %s [--serve SOCKET] [--cpus LIST] "
+            "[--batch N] [--global-queue] [--spin N] [--record LOG | --replay LOG] "
+            "[--compile SCRIPT]...\n", prog);
+    return 1;
+}
+
 // Start of everything
 int main(int argc, char *argv[]) {
     printf("Shell version 1.5 created Dec 2025\n");
 
+    char *serve_path = NULL;
+    char *compile_paths[argc];
+    int compile_count = 0;
+    // --record and --replay exclude each other. Checked up front, so a
+    // --record LOG does not truncate the log a --replay was given.
+    int record_given = 0, replay_given = 0;
+    for (int i = 1; i < argc; i++) {
+        record_given |= strcmp(argv[i], "--record") == 0;
+        replay_given |= strcmp(argv[i], "--replay") == 0;
+    }
+    if (record_given && replay_given) {
+        return usage(argv[0]);
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            // long-running service mode, see server.h
+            serve_path = argv[++i];
+        } else if (strcmp(argv[i], "--cpus") == 0 && i + 1 < argc) {
+            // pin MT worker i to the i-th listed CPU
+            if (affinity_set_cpu_list(argv[++i]) != 0) {
+                fprintf(stderr, "mysh: bad cpu list: %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            // MT workers take up to N processes per queue lock
+            int n;
+            if (parse_int_arg(argv[++i], 1, MT_MAX_BATCH, &n) != 0) {
+                fprintf(stderr, "mysh: bad batch size (1-%d): %s\n", MT_MAX_BATCH, argv[i]);
+                return 1;
+            }
+            scheduler_set_batch_size(n);
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            // log MT dispatch decisions, see replaylog.h
+            if (replaylog_record_open(argv[++i]) != 0) {
+                fprintf(stderr, "mysh: cannot write %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            // re-run MT slices in the order a --record log gives
+            if (replaylog_replay_open(argv[++i]) != 0) {
+                fprintf(stderr, "mysh: cannot read replay log %s\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--spin") == 0 && i + 1 < argc) {
+            // pauses an idle MT worker spins before it parks
+            int n;
+            if (parse_int_arg(argv[++i], 0, INT_MAX, &n) != 0) {
+                fprintf(stderr, "mysh: bad spin count: %s\n", argv[i]);
+                return 1;
+            }
+            scheduler_set_spin(n);
+        } else if (strcmp(argv[i], "--global-queue") == 0) {
+            // no per-worker run queues, see scheduler_set_local_queues
+            scheduler_set_local_queues(0);
+        } else if (strcmp(argv[i], "--compile") == 0 && i + 1 < argc) {
+            // write SCRIPT.mshc and exit, see progimage.h
+            compile_paths[compile_count++] = argv[++i];
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (compile_count > 0) {
+        int rc = 0;
+        mem_init();
+        for (int i = 0; i < compile_count; i++) {
+            if (progimage_compile(compile_paths[i]) != 0) {
+                fprintf(stderr, "mysh: cannot compile %s\n", compile_paths[i]);
+                rc = 1;
+            }
+        }
+        return rc;
+    }
+    if (serve_path != NULL) {
+        mem_init();
+        return server_run(serve_path);
+    }
+
     char prompt = '$';          // Shell prompt
-    char userInput[MAX_USER_INPUT];     // user's input stored here
+    char *userInput;            // user's input, in place in the reader
+    LineReader reader;          // streams stdin, any line length
     // batch_mode is true when a file was given.
     int batch_mode = !isatty(STDIN_FILENO);
     int errorCode = 0;          // zero means no error, default
 
-    //init user input
-    for (int i = 0; i < MAX_USER_INPUT; i++) {
-        userInput[i] = '\0';
+    if (linereader_init(&reader, STDIN_FILENO) != 0) {
+        fprintf(stderr, "mysh: out of memory\n");
+        return 1;
     }
 
     //init shell memory
@@ -29,35 +137,34 @@ int main(int argc, char *argv[]) {
     while (1) {
         if (!batch_mode) {
             printf("%c ", prompt);
+            fflush(stdout);     // we read the fd directly, not through stdio
         }
         // here you should check the unistd library 
         // so that you can find a way to not display $ in the batch mode
-        fgets(userInput, MAX_USER_INPUT - 1, stdin);
+        userInput = linereader_next(&reader);
+        if (userInput == NULL) {
+            return 0;           // EOF
+        }
         errorCode = parseInput(userInput);
         if (errorCode == -1)
             exit(99);           // ignore all other errors
-
-        if (feof(stdin)) {
-            return 0;
-        }
-
-        memset(userInput, 0, sizeof(userInput));
     }
 
     return 0;
 }
 
-int wordEnding(char c) {
-    // You may want to add ';' to this at some point,
-    // or you may want to find a different way to implement chains.
-    return c == '\0' || c == '\n' || isspace(c) || c == ';';
+static int badcommandTooManyTokens() {
+    printf("Bad command: too many tokens\n");
+    return 1;
 }
 
 int parseInput(char inp[]) {
-    char tmp[200], *words[100];
+    char *words[MAX_WORDS];
+    Token tokens[MAX_WORDS];
     int ix = 0, w = 0;
-    int wordlen;
+    int too_many = 0;
     int errorCode = 0;
+    HOTSTAT_START(parse_t0);
 
     // This function probably isn't the best place to handle chains.
     // That is, if we really wanted to implement relatively complex
@@ -68,42 +175,22 @@ int parseInput(char inp[]) {
     // command dispatch, and this function is really acting as a complete
     // parser rather than just a tokenizer. So we'll handle it here.
 
-    while (inp[ix] != '\n' && inp[ix] != '\0' && ix < 1000) {
-        // skip white spaces
-        for (; isspace(inp[ix]) && inp[ix] != '\n' && ix < 1000; ix++);
-
-        // If the next character is a hash (#), add it as a token then continue
-        if (inp[ix] == '#') {
-            words[w] = strdup("#");
-            w++;
-            ix++;
-            continue;
-        }
-
-        // If the next character is a semicolon,
-        // we should run what we have so far.
-        if (inp[ix] == ';')
-            break;
-
-        // extract a word
-        for (wordlen = 0; !wordEnding(inp[ix]) && inp[ix] != '#' && ix < 1000; ix++, wordlen++) {
-            tmp[wordlen] = inp[ix];
-        }
-
-        if (wordlen > 0) {
-            tmp[wordlen] = '\0';
-            words[w] = strdup(tmp);
-            w++;
-            if (inp[ix] == '\0')
-                break;
-        } else {
-            break;
-        }
+    // tokenize (tokenizer.c) scans a whole command for word boundaries,
+    // 16 or 32 bytes at a time where the CPU allows. Past MAX_WORDS the
+    // command is rejected below rather than silently truncated.
+    w = tokenize(inp, tokens, MAX_WORDS, &ix, &too_many);
+    for (int i = 0; i < w && !too_many; i++) {
+        words[i] = strndup(tokens[i].start, tokens[i].len);
     }
+    HOTSTAT_STOP(HS_PARSE, parse_t0);
     // Ignore commands that contain no (meaningful) input by only calling the
     // interpreter if actually found words.
-    if (w > 0) {
+    if (too_many) {
+        errorCode = badcommandTooManyTokens();
+    } else if (w > 0) {
+        HOTSTAT_START(interpret_t0);
         errorCode = interpreter(words, w);
+        HOTSTAT_STOP(HS_INTERPRET, interpret_t0);
         for (size_t i = 0; i < w; ++i) {
             free(words[i]);
         }
@@ -113,9 +200,9 @@ int parseInput(char inp[]) {
         // the parser. We could equivalently wrap all of the work above
         // in a while loop, but this makes it clearer what's going on.
         // Additionally, a modern compiler is more than smart enough to
-        // turn this into a loop for us! Try adding -O2 to the CFLAGS in
-        // the Makefile and then read the assembly we get.
-        // Or you might be interested in godbolt.org.
+        // turn this into a loop for us! The release build (-O2, see the
+        // Makefile) does; read the assembly we get with `make debug` and
+        // `make release` to compare. Or try godbolt.org.
         return parseInput(&inp[ix + 1]);
     }
     return errorCode;
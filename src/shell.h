@@ -1,2 +1,3 @@
 #define MAX_USER_INPUT 1000
+#define MAX_WORDS 100 // tokens per command
 int parseInput(char inp[]);
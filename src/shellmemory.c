@@ -1,29 +1,51 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <pthread.h>
 #include "shellmemory.h"
+#include "hotstats.h"
+#include "intern.h"
 
+// Names and values are interned (intern.h): a name matches by pointer,
+// and equal values share one copy. var is NULL in a free slot.
 struct memory_struct {
-    char *var;
-    char *value;
+    const char *var;
+    const char *value;
 };
 
 struct memory_struct shellmemory[MEM_SIZE];
 
 // For script storage
-struct code_struct{
-    char *line;
-};
-struct code_struct shell_code[MEM_SIZE];
+CodeLine shell_code[MEM_SIZE];
 
 int code_idx = 0;
+char mem_unloaded_line[] = "";
+// Background MT workers free finished scripts while the shell thread may be
+// loading the next exec, so allocation and cleanup are serialized.
+static pthread_mutex_t code_mutex = PTHREAD_MUTEX_INITIALIZER;
+// MT workers share shellmemory, so the global variable store is guarded
+// too. Isolated processes do not touch it (see VarScope below).
+static pthread_rwlock_t var_lock = PTHREAD_RWLOCK_INITIALIZER;
 
-int mem_load_script_line(char *line) {  
-    if (code_idx < MEM_SIZE) {
-        shell_code[code_idx].line = strdup(line);
-        return code_idx++; // Return current index and increment
+// Places a whole script in one contiguous block, so scripts loaded at the
+// same time (nested execs on the MT workers) never interleave. Takes over
+// the interned lines. Returns the first index, or -1 if it does not fit.
+int mem_load_script(char **lines, int count) {
+    int start = -1; // Out of memory
+    pthread_mutex_lock(&code_mutex);
+    if (count <= MEM_SIZE - code_idx) {
+        start = code_idx;
+        for (int i = 0; i < count; i++) {
+            shell_code[start + i].line = lines[i];
+            shell_code[start + i].op = OP_CMD;
+            shell_code[start + i].arg = 0;
+            shell_code[start + i].target = -1;
+            shell_code[start + i].borrowed = 0;
+        }
+        code_idx += count;
     }
-    return -1; // Out of memory
+    pthread_mutex_unlock(&code_mutex);
+    return start;
 }
 
 char *mem_get_line(int index) {
@@ -31,16 +53,27 @@ char *mem_get_line(int index) {
     return NULL;
 }
 
+CodeLine *mem_get_code(int index) {
+    if (index >= 0 && index < MEM_SIZE) return &shell_code[index];
+    return NULL;
+}
+
 void mem_cleanup_script(int start, int end) {  // Free memory used by a script from start to end
+    pthread_mutex_lock(&code_mutex);
     for (int i = start; i <= end && i < MEM_SIZE; i++) {
         if (shell_code[i].line != NULL) {
-            free(shell_code[i].line);
+            if (shell_code[i].line != mem_unloaded_line && !shell_code[i].borrowed) {
+                intern_release(shell_code[i].line);
+            }
             shell_code[i].line = NULL;
+            shell_code[i].op = OP_CMD;
         }
     }
-    while (code_idx > 0 && shell_code[code_idx - 1].line == NULL) {
+    while (code_idx > 0
+           && __atomic_load_n(&shell_code[code_idx - 1].line, __ATOMIC_RELAXED) == NULL) {
         code_idx--;
     }
+    pthread_mutex_unlock(&code_mutex);
 }
 
 // Helper functions
@@ -61,44 +94,316 @@ int match(char *model, char *var) {
 void mem_init(void) {
     int i;
     for (i = 0; i < MEM_SIZE; i++) {
-        shellmemory[i].var = "none";
-        shellmemory[i].value = "none";
+        shellmemory[i].var = NULL;
+        shellmemory[i].value = NULL;
         shell_code[i].line = NULL;
     }
     code_idx = 0;
 }
 
-// Set key value pair
-void mem_set_value(char *var_in, char *value_in) {
-    int i;
+// Set key value pair. Takes over the caller's references to var and value.
+static int global_set_value(const char *var, const char *value) {
+    int i, free_slot = -1;
 
     for (i = 0; i < MEM_SIZE; i++) {
-        if (strcmp(shellmemory[i].var, var_in) == 0) {
-            shellmemory[i].value = strdup(value_in);
-            return;
+        if (shellmemory[i].var == var) {
+            intern_release(shellmemory[i].value);
+            shellmemory[i].value = value;
+            intern_release(var);
+            return 0;
+        }
+        if (shellmemory[i].var == NULL && free_slot < 0) {
+            free_slot = i;
         }
     }
 
-    //Value does not exist, need to find a free spot.
+    //Value does not exist, use the first free spot.
+    if (free_slot >= 0) {
+        shellmemory[free_slot].var = var;
+        shellmemory[free_slot].value = value;
+        return 1;
+    }
+    intern_release(var);
+    intern_release(value);
+    return 0;
+}
+
+//get value based on input key (interned)
+static char *global_get_value(const char *var) {
+    int i;
+
     for (i = 0; i < MEM_SIZE; i++) {
-        if (strcmp(shellmemory[i].var, "none") == 0) {
-            shellmemory[i].var = strdup(var_in);
-            shellmemory[i].value = strdup(value_in);
-            return;
+        if (shellmemory[i].var == var) {
+            return strdup(shellmemory[i].value);
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Per-process variable scopes (exec ... ISOLATE).
+ * An isolated exec takes one snapshot of shellmemory that all its PCBs
+ * share read-only, and each PCB writes into its own overlay table. Lookups
+ * go overlay -> snapshot; the snapshot never changes, so only the overlay
+ * is locked. Programs an isolated PCB sources or execs (without ISOLATE)
+ * share its scope, overlay included, as other programs share shellmemory,
+ * and may run on other workers meanwhile. export copies a private value
+ * back into shellmemory.
+ */
+typedef struct {
+    const char *var;            // interned, like shellmemory
+    const char *value;
+} VarEntry;
+
+typedef struct {
+    int cap;                    // power of two, 0 when empty
+    int count;
+    VarEntry *slots;
+} VarTable;
+
+struct VarSnapshot {
+    VarTable table;
+    int refs;                   // PCB scopes + the exec that took it
+};
+
+struct VarScope {
+    VarSnapshot *base;
+    VarTable local;
+    pthread_mutex_t lock;       // local, for programs sharing the scope
+    int refs;                   // PCBs sharing it
+};
+
+static __thread VarScope *current_scope = NULL;
+
+// Slot holding var (interned), or the empty slot where it would go.
+static VarEntry *var_table_slot(const VarTable *t, const char *var) {
+    unsigned mask = t->cap - 1;
+    unsigned i = intern_hash(var) & mask;
+    while (t->slots[i].var != NULL && t->slots[i].var != var) {
+        i = (i + 1) & mask;
+    }
+    return &t->slots[i];
+}
+
+static const char *var_table_get(const VarTable *t, const char *var) {
+    if (t->cap == 0) return NULL;
+    return var_table_slot(t, var)->value;
+}
+
+// Takes over the caller's references to var and value.
+static int var_table_put(VarTable *t, const char *var, const char *value) {
+    VarEntry *e = t->cap ? var_table_slot(t, var) : NULL;
+    if (e != NULL && e->var != NULL) {
+        intern_release(e->value);
+        e->value = value;
+        intern_release(var);
+        return 0;
+    }
+    if (t->count + 1 > t->cap * 3 / 4) {
+        VarTable grown = { t->cap ? t->cap * 2 : 16, t->count, NULL };
+        if (t->count >= MEM_SIZE                 // full, same as shellmemory
+            || (grown.slots = calloc(grown.cap, sizeof(VarEntry))) == NULL) {
+            intern_release(var);
+            intern_release(value);
+            return 0;
+        }
+        for (int i = 0; i < t->cap; i++) {
+            if (t->slots[i].var != NULL) {
+                *var_table_slot(&grown, t->slots[i].var) = t->slots[i];
+            }
         }
+        free(t->slots);
+        *t = grown;
+        e = var_table_slot(t, var);
     }
+    e->var = var;
+    e->value = value;
+    t->count++;
+    return 1;
+}
 
-    return;
+static void var_table_free(VarTable *t) {
+    for (int i = 0; i < t->cap; i++) {
+        intern_release(t->slots[i].var);
+        intern_release(t->slots[i].value);
+    }
+    free(t->slots);
+    t->slots = NULL;
+    t->cap = t->count = 0;
+}
+
+// The variables as the caller sees them: shellmemory, or from inside an
+// isolated program its snapshot with its own writes on top.
+VarSnapshot *mem_snapshot_take(void) {
+    VarSnapshot *snap = calloc(1, sizeof(VarSnapshot));
+    if (snap == NULL) return NULL;
+    snap->refs = 1;
+    if (current_scope != NULL) {
+        const VarTable *layers[2] = { &current_scope->base->table,
+                                      &current_scope->local };
+        pthread_mutex_lock(&current_scope->lock);
+        for (int l = 0; l < 2; l++) {
+            for (int i = 0; i < layers[l]->cap; i++) {
+                const VarEntry *e = &layers[l]->slots[i];
+                if (e->var != NULL) {
+                    var_table_put(&snap->table, intern_dup(e->var),
+                                  intern_dup(e->value));
+                }
+            }
+        }
+        pthread_mutex_unlock(&current_scope->lock);
+        return snap;
+    }
+    pthread_rwlock_rdlock(&var_lock);
+    for (int i = 0; i < MEM_SIZE; i++) {
+        if (shellmemory[i].var != NULL) {
+            var_table_put(&snap->table, intern_dup(shellmemory[i].var),
+                          intern_dup(shellmemory[i].value));
+        }
+    }
+    pthread_rwlock_unlock(&var_lock);
+    return snap;
+}
+
+void mem_snapshot_release(VarSnapshot *snap) {
+    if (snap != NULL && __atomic_sub_fetch(&snap->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        var_table_free(&snap->table);
+        free(snap);
+    }
+}
+
+VarScope *mem_scope_create(VarSnapshot *base) {
+    VarScope *scope = calloc(1, sizeof(VarScope));
+    if (scope == NULL) return NULL;
+    __atomic_add_fetch(&base->refs, 1, __ATOMIC_RELAXED);
+    scope->base = base;
+    scope->refs = 1;
+    pthread_mutex_init(&scope->lock, NULL);
+    return scope;
+}
+
+VarScope *mem_scope_share(VarScope *scope) {
+    __atomic_add_fetch(&scope->refs, 1, __ATOMIC_RELAXED);
+    return scope;
+}
+
+void mem_scope_free(VarScope *scope) {
+    if (scope == NULL || __atomic_sub_fetch(&scope->refs, 1, __ATOMIC_ACQ_REL) != 0) {
+        return;
+    }
+    pthread_mutex_destroy(&scope->lock);
+    var_table_free(&scope->local);
+    mem_snapshot_release(scope->base);
+    free(scope);
+}
+
+// The scheduler points this at the running PCB's scope for each slice.
+void mem_set_current_scope(VarScope *scope) {
+    current_scope = scope;
+}
+
+// Set key value pair
+int mem_set_value(char *var_in, char *value_in) {
+    int created = 0;
+    HOTSTAT_START(t0);
+    const char *var = intern(var_in);
+    const char *value = intern(value_in);
+
+    if (var == NULL || value == NULL) {
+        intern_release(var);
+        intern_release(value);
+    } else if (current_scope != NULL) {
+        pthread_mutex_lock(&current_scope->lock);
+        created = var_table_put(&current_scope->local, var, value);
+        pthread_mutex_unlock(&current_scope->lock);
+    } else {
+        pthread_rwlock_wrlock(&var_lock);
+        created = global_set_value(var, value);
+        pthread_rwlock_unlock(&var_lock);
+    }
+    HOTSTAT_STOP(HS_VAR_SET, t0);
+    return created;
+}
+
+// Whether mem_set_value(var) would overwrite rather than create: in an
+// isolated program only its own writes count, not the snapshot's.
+int mem_var_is_set(char *var_in) {
+    const char *var = intern_lookup(var_in);
+    int set = 0;
+
+    if (var != NULL && current_scope != NULL) {
+        pthread_mutex_lock(&current_scope->lock);
+        set = var_table_get(&current_scope->local, var) != NULL;
+        pthread_mutex_unlock(&current_scope->lock);
+    } else if (var != NULL) {
+        pthread_rwlock_rdlock(&var_lock);
+        for (int i = 0; i < MEM_SIZE && !set; i++) {
+            set = shellmemory[i].var == var;
+        }
+        pthread_rwlock_unlock(&var_lock);
+    }
+    intern_release(var);
+    return set;
 }
 
 //get value based on input key
 char *mem_get_value(char *var_in) {
-    int i;
+    char *value = NULL;
+    HOTSTAT_START(t0);
+    // A name nobody interned cannot be set anywhere.
+    const char *var = intern_lookup(var_in);
 
-    for (i = 0; i < MEM_SIZE; i++) {
-        if (strcmp(shellmemory[i].var, var_in) == 0) {
-            return strdup(shellmemory[i].value);
+    if (var != NULL && current_scope != NULL) {
+        pthread_mutex_lock(&current_scope->lock);
+        const char *v = var_table_get(&current_scope->local, var);
+        if (v == NULL) {
+            v = var_table_get(&current_scope->base->table, var);
         }
+        value = v ? strdup(v) : NULL;
+        pthread_mutex_unlock(&current_scope->lock);
+    } else if (var != NULL) {
+        pthread_rwlock_rdlock(&var_lock);
+        value = global_get_value(var);
+        pthread_rwlock_unlock(&var_lock);
     }
-    return NULL;
+    intern_release(var);
+    HOTSTAT_STOP(HS_VAR_GET, t0);
+    return value;
+}
+
+// Calls fn on every global variable, in slot order, until it returns
+// nonzero; returns that value. fn must not set variables.
+int mem_for_each_var(int (*fn)(const char *var, const char *value, void *arg),
+                     void *arg) {
+    int rc = 0;
+    pthread_rwlock_rdlock(&var_lock);
+    for (int i = 0; i < MEM_SIZE && rc == 0; i++) {
+        if (shellmemory[i].var != NULL) {
+            rc = fn(shellmemory[i].var, shellmemory[i].value, arg);
+        }
+    }
+    pthread_rwlock_unlock(&var_lock);
+    return rc;
+}
+
+// Publish the caller's value of var to shellmemory. Returns 0 if var is set.
+int mem_export_value(char *var_in) {
+    char *value = mem_get_value(var_in);
+    if (value == NULL) {
+        return 1;
+    }
+    if (current_scope != NULL) {
+        const char *var = intern(var_in);
+        const char *v = intern(value);
+        if (var != NULL && v != NULL) {
+            pthread_rwlock_wrlock(&var_lock);
+            global_set_value(var, v);
+            pthread_rwlock_unlock(&var_lock);
+        } else {
+            intern_release(var);
+            intern_release(v);
+        }
+    }
+    free(value);
+    return 0;
 }
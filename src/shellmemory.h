@@ -5,10 +5,47 @@
 
 void mem_init(void);
 char *mem_get_value(char *var);
-void mem_set_value(char *var, char *value);
+int mem_set_value(char *var, char *value);  // 1 if var was created
+int mem_var_is_set(char *var);  // 0 if mem_set_value would create var
+int mem_export_value(char *var);
+// Global variables only, in slot order; stops at fn's first nonzero return
+int mem_for_each_var(int (*fn)(const char *var, const char *value, void *arg),
+                     void *arg);
 
-int mem_load_script_line(char *line);
+// Copy-on-write variable scopes for exec ... ISOLATE (see shellmemory.c)
+typedef struct VarSnapshot VarSnapshot;
+typedef struct VarScope VarScope;
+VarSnapshot *mem_snapshot_take(void);
+void mem_snapshot_release(VarSnapshot *snap);
+VarScope *mem_scope_create(VarSnapshot *base);
+VarScope *mem_scope_share(VarScope *scope);   // one more PCB on scope
+void mem_scope_free(VarScope *scope);
+void mem_set_current_scope(VarScope *scope);
+
+// Script control flow: plain lines are OP_CMD. repeat/if/end lines are
+// turned into jumps by control_compile (see control.c).
+typedef enum {
+    OP_CMD = 0,
+    OP_REPEAT,
+    OP_IF,
+    OP_END
+} CodeOp;
+
+typedef struct {
+    char *line;
+    CodeOp op;
+    int arg;            // OP_REPEAT: iteration count
+    int target;         // OP_REPEAT/OP_IF: matching end. OP_END: its opener
+    int borrowed;       // line points into a compiled image, not freed here
+} CodeLine;
+
+// Placeholder for a line of a mapped script that has not run yet (see
+// scriptload.h).
+extern char mem_unloaded_line[];
+
+int mem_load_script(char **lines, int count);
 char *mem_get_line(int index);
+CodeLine *mem_get_code(int index);
 void mem_cleanup_script(int start, int end);
 
 #endif
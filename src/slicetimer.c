@@ -0,0 +1,80 @@
+#define _GNU_SOURCE             // SIGEV_THREAD_ID, gettid
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "slicetimer.h"
+
+#define SLICETIMER_SIGNAL (SIGRTMIN + 1)
+
+__thread volatile sig_atomic_t slicetimer_fired = 0;
+static __thread timer_t thread_timer;
+static __thread int thread_timer_ready = 0;   // -1 if it cannot be created
+static pthread_once_t handler_once = PTHREAD_ONCE_INIT;
+
+static void slicetimer_handler(int sig) {
+    (void)sig;
+    slicetimer_fired = 1;
+}
+
+static void slicetimer_install_handler(void) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = slicetimer_handler;
+    sa.sa_flags = SA_RESTART;   // commands' own I/O just carries on
+    sigemptyset(&sa.sa_mask);
+    sigaction(SLICETIMER_SIGNAL, &sa, NULL);
+}
+
+// Timers are per thread and created on first use.
+static int slicetimer_create(void) {
+    struct sigevent sev;
+
+    pthread_once(&handler_once, slicetimer_install_handler);
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = SLICETIMER_SIGNAL;
+    sev._sigev_un._tid = gettid();
+    if (timer_create(CLOCK_MONOTONIC, &sev, &thread_timer) != 0) {
+        perror("mysh: timer_create");
+        thread_timer_ready = -1;    // reported once; the caller falls back
+        return -1;
+    }
+    thread_timer_ready = 1;
+    return 0;
+}
+
+int slicetimer_arm(int ms) {
+    struct itimerspec its;
+
+    if (thread_timer_ready < 0
+        || (thread_timer_ready == 0 && slicetimer_create() != 0)) {
+        return -1;
+    }
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = ms / 1000;
+    its.it_value.tv_nsec = (long)(ms % 1000) * 1000000L;
+    slicetimer_fired = 0;
+    return timer_settime(thread_timer, 0, &its, NULL);
+}
+
+void slicetimer_disarm(void) {
+    struct itimerspec its;
+
+    if (thread_timer_ready <= 0) {
+        return;
+    }
+    memset(&its, 0, sizeof(its));
+    timer_settime(thread_timer, 0, &its, NULL);
+    slicetimer_fired = 0;
+}
+
+void slicetimer_release(void) {
+    if (thread_timer_ready > 0) {
+        timer_delete(thread_timer);
+    }
+    thread_timer_ready = 0;
+}
@@ -0,0 +1,16 @@
+#ifndef SLICETIMER_H
+#define SLICETIMER_H
+
+#include <signal.h>
+
+// Wall-clock quanta (exec ... TIMESLICE MS). Each scheduling thread owns a
+// POSIX timer that signals only that thread; the handler just raises
+// slicetimer_fired, and the scheduler yields at the next instruction
+// boundary once it sees the flag.
+extern __thread volatile sig_atomic_t slicetimer_fired;
+
+int slicetimer_arm(int ms);     // 0 on success, starts the calling thread's slice
+void slicetimer_disarm(void);
+void slicetimer_release(void);  // deletes the calling thread's timer, if any
+
+#endif
@@ -0,0 +1,232 @@
+#include <ctype.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "tokenizer.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TOKENIZER_X86 1
+#endif
+
+static int wordEnding(char c) {
+    // You may want to add ';' to this at some point,
+    // or you may want to find a different way to implement chains.
+    return c == '\0' || c == '\n' || isspace(c) || c == ';';
+}
+
+static void emit(Token *tokens, int max, int *count, int *overflow,
+                 const char *start, int len) {
+    if (*count < max) {
+        tokens[*count].start = start;
+        tokens[*count].len = len;
+        (*count)++;
+    } else {
+        *overflow = 1;
+    }
+}
+
+// The original parseInput scanner, kept as the reference.
+static int tokenize_scalar(const char *inp, Token *tokens, int max,
+                           int *stop, int *overflow) {
+    int ix = 0, w = 0, wordlen;
+
+    *overflow = 0;
+    while (inp[ix] != '\n' && inp[ix] != '\0') {
+        // skip white spaces
+        for (; isspace(inp[ix]) && inp[ix] != '\n'; ix++);
+
+        // If the next character is a hash (#), add it as a token then continue
+        if (inp[ix] == '#') {
+            emit(tokens, max, &w, overflow, &inp[ix], 1);
+            ix++;
+            continue;
+        }
+
+        // If the next character is a semicolon,
+        // we should run what we have so far.
+        if (inp[ix] == ';')
+            break;
+
+        // extract a word (words may be any length)
+        for (wordlen = 0; !wordEnding(inp[ix]) && inp[ix] != '#'; ix++, wordlen++);
+
+        if (wordlen > 0) {
+            emit(tokens, max, &w, overflow, &inp[ix - wordlen], wordlen);
+            if (inp[ix] == '\0')
+                break;
+        } else {
+            break;
+        }
+    }
+    *stop = ix;
+    return w;
+}
+
+#ifdef TOKENIZER_X86
+/*
+ * SIMD scanners. Each aligned block of 16 (SSE2) or 32 (AVX2) bytes is
+ * classified into three bitmasks at once: delimiters (whitespace, ';',
+ * '#', '\0'), stops (';', '\n', '\0') and hashes. Token boundaries then
+ * fall out of the masks with ctz, one token per bit scan instead of one
+ * test per byte. Aligned loads never cross a page, so reading up to the
+ * end of the block holding the '\0' is safe.
+ */
+typedef struct {
+    const char *base;   // block start
+    int in_word;
+    const char *word;   // start of the word being scanned
+    int count;
+    int done;
+    int stop;
+} ScanState;
+
+// Walk one block's masks from bit pos. Returns when the block is used up
+// or the command ended.
+static inline void scan_block(ScanState *st, const char *inp, uint32_t delim,
+                              uint32_t stops, uint32_t hashes, int pos,
+                              int width, Token *tokens, int max, int *overflow) {
+    uint32_t live = width == 32 ? 0xffffffffu : (1u << width) - 1;
+    while (pos < width) {
+        uint32_t from = live & ~((1u << pos) - 1);
+        uint32_t m;
+        int i;
+        if (st->in_word) {
+            m = delim & from;
+            if (m == 0) {
+                return;     // word runs into the next block
+            }
+            i = __builtin_ctz(m);
+            emit(tokens, max, &st->count, overflow, st->word,
+                 (int)(st->base + i - st->word));
+            st->in_word = 0;
+            pos = i;
+        } else {
+            m = (~delim | stops | hashes) & from;
+            if (m == 0) {
+                return;
+            }
+            i = __builtin_ctz(m);
+            if (stops & (1u << i)) {
+                st->done = 1;
+                st->stop = (int)(st->base + i - inp);
+                return;
+            }
+            if (hashes & (1u << i)) {
+                emit(tokens, max, &st->count, overflow, st->base + i, 1);
+                pos = i + 1;
+            } else {
+                st->in_word = 1;
+                st->word = st->base + i;
+                pos = i;
+            }
+        }
+    }
+}
+
+// Whitespace is 0x09..0x0d (\t \n \v \f \r) or ' ', which is what
+// isspace accepts in the C locale; (c - 9) <= 4 unsigned tests the range.
+__attribute__((target("sse2")))
+static inline void classify_sse2(__m128i v, uint32_t *delim, uint32_t *stops,
+                                 uint32_t *hashes) {
+    __m128i off = _mm_sub_epi8(v, _mm_set1_epi8(9));
+    __m128i ws = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                              _mm_cmpeq_epi8(_mm_min_epu8(off, _mm_set1_epi8(4)), off));
+    __m128i stop = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                                             _mm_cmpeq_epi8(v, _mm_set1_epi8(';'))),
+                                _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+    __m128i hash = _mm_cmpeq_epi8(v, _mm_set1_epi8('#'));
+    *stops = (uint32_t)_mm_movemask_epi8(stop);
+    *hashes = (uint32_t)_mm_movemask_epi8(hash);
+    *delim = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(ws, stop), hash));
+}
+
+__attribute__((target("avx2")))
+static inline void classify_avx2(__m256i v, uint32_t *delim, uint32_t *stops,
+                                 uint32_t *hashes) {
+    __m256i off = _mm256_sub_epi8(v, _mm256_set1_epi8(9));
+    __m256i ws = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                 _mm256_cmpeq_epi8(_mm256_min_epu8(off, _mm256_set1_epi8(4)), off));
+    __m256i stop = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                                                   _mm256_cmpeq_epi8(v, _mm256_set1_epi8(';'))),
+                                   _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+    __m256i hash = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('#'));
+    *stops = (uint32_t)_mm256_movemask_epi8(stop);
+    *hashes = (uint32_t)_mm256_movemask_epi8(hash);
+    *delim = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(ws, stop), hash));
+}
+
+// Both scanners start at the aligned block holding inp, skipping the bytes
+// before it, and stop at the block holding the command's end. Bytes past
+// the '\0' in that block are read but ignored, which the sanitizers would
+// report, so they are exempt.
+__attribute__((target("sse2"), no_sanitize("address", "thread")))
+static int tokenize_sse2(const char *inp, Token *tokens, int max, int *stop,
+                         int *overflow) {
+    ScanState st = {0};
+    const char *p = (const char *)((uintptr_t)inp & ~(uintptr_t)15);
+    int pos = (int)(inp - p);
+    uint32_t delim, stops, hashes;
+
+    *overflow = 0;
+    for (;; p += 16, pos = 0) {
+        classify_sse2(_mm_load_si128((const __m128i *)p), &delim, &stops, &hashes);
+        st.base = p;
+        scan_block(&st, inp, delim, stops, hashes, pos, 16, tokens, max, overflow);
+        if (st.done) {
+            *stop = st.stop;
+            return st.count;
+        }
+    }
+}
+
+__attribute__((target("avx2"), no_sanitize("address", "thread")))
+static int tokenize_avx2(const char *inp, Token *tokens, int max, int *stop,
+                         int *overflow) {
+    ScanState st = {0};
+    const char *p = (const char *)((uintptr_t)inp & ~(uintptr_t)31);
+    int pos = (int)(inp - p);
+    uint32_t delim, stops, hashes;
+
+    *overflow = 0;
+    for (;; p += 32, pos = 0) {
+        classify_avx2(_mm256_load_si256((const __m256i *)p), &delim, &stops, &hashes);
+        st.base = p;
+        scan_block(&st, inp, delim, stops, hashes, pos, 32, tokens, max, overflow);
+        if (st.done) {
+            *stop = st.stop;
+            return st.count;
+        }
+    }
+}
+#endif
+
+static TokenizeFn tokenize_best = NULL;
+
+TokenizeFn tokenize_impl(const char *name) {
+    if (strcmp(name, "scalar") == 0) {
+        return tokenize_scalar;
+    }
+#ifdef TOKENIZER_X86
+    __builtin_cpu_init();
+    if (strcmp(name, "sse2") == 0 && __builtin_cpu_supports("sse2")) {
+        return tokenize_sse2;
+    }
+    if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2")) {
+        return tokenize_avx2;
+    }
+#endif
+    return NULL;
+}
+
+int tokenize(const char *inp, Token *tokens, int max, int *stop, int *overflow) {
+    TokenizeFn fn = __atomic_load_n(&tokenize_best, __ATOMIC_RELAXED);
+    if (fn == NULL) {
+        // Racing first calls all pick the same function.
+        fn = tokenize_impl("avx2");
+        if (fn == NULL) fn = tokenize_impl("sse2");
+        if (fn == NULL) fn = tokenize_scalar;
+        __atomic_store_n(&tokenize_best, fn, __ATOMIC_RELAXED);
+    }
+    return fn(inp, tokens, max, stop, overflow);
+}
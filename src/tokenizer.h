@@ -0,0 +1,26 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+// Command tokenizer used by parseInput. Words are runs of bytes other than
+// whitespace, ';', '#', '\n' and '\0'; a '#' is a token of its own; the
+// command ends at the first ';', '\n' or '\0'.
+typedef struct {
+    const char *start;
+    int len;
+} Token;
+
+// Fills up to max tokens of the command at inp and returns how many.
+// *stop is the offset of the byte that ended the command, and *overflow is
+// set when the command has more than max tokens.
+typedef int (*TokenizeFn)(const char *inp, Token *tokens, int max,
+                          int *stop, int *overflow);
+
+// Picks the widest implementation this CPU supports on first use.
+int tokenize(const char *inp, Token *tokens, int max, int *stop, int *overflow);
+
+// One implementation by name: "scalar" (the byte-at-a-time reference),
+// "sse2" or "avx2". NULL if this build or CPU lacks it. Used by
+// bench/tokcheck.c to check the SIMD scanners against the reference.
+TokenizeFn tokenize_impl(const char *name);
+
+#endif
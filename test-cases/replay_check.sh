@@ -0,0 +1,13 @@
+#!/bin/sh
+# Records an MT RR exec, replays its log and reports whether the replay
+# printed the same. T_REPLAY runs it, so its parent is the mysh under test.
+mysh=$(readlink /proc/$PPID/exe)
+printf 'exec P_prog1 P_prog2 P_prog3 RR MT\nquit\n' > replay_in.tmp
+"$mysh" --record replay.log < replay_in.tmp > replay_rec.tmp
+"$mysh" --replay replay.log < replay_in.tmp > replay_rep.tmp
+if [ -s replay.log ] && cmp -s replay_rec.tmp replay_rep.tmp; then
+    echo replay matches
+else
+    echo replay differs
+fi
+rm -f replay_in.tmp replay_rec.tmp replay_rep.tmp replay.log